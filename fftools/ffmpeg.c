@@ -4104,7 +4104,9 @@ static void *input_thread(void *arg)
             av_thread_message_queue_set_err_recv(f->in_thread_queue, ret);
             break;
         }
-        queue_pkt = av_packet_alloc();
+        if (av_thread_message_queue_recv(f->pkt_recycle_queue, &queue_pkt,
+                                         AV_THREAD_MESSAGE_NONBLOCK) < 0)
+            queue_pkt = av_packet_alloc();
         if (!queue_pkt) {
             av_packet_unref(pkt);
             av_thread_message_queue_set_err_recv(f->in_thread_queue, AVERROR(ENOMEM));
@@ -4148,6 +4150,11 @@ static void free_input_thread(int i)
     pthread_join(f->thread, NULL);
     f->joined = 1;
     av_thread_message_queue_free(&f->in_thread_queue);
+
+    while (av_thread_message_queue_recv(f->pkt_recycle_queue, &pkt,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0)
+        av_packet_free(&pkt);
+    av_thread_message_queue_free(&f->pkt_recycle_queue);
 }
 
 static void free_input_threads(void)
@@ -4176,9 +4183,19 @@ static int init_input_thread(int i)
     if (ret < 0)
         return ret;
 
+    /* packets handed back by the main thread once processed, so the
+     * reading thread does not allocate a new one for every packet */
+    ret = av_thread_message_queue_alloc(&f->pkt_recycle_queue,
+                                        f->thread_queue_size, sizeof(f->pkt));
+    if (ret < 0) {
+        av_thread_message_queue_free(&f->in_thread_queue);
+        return ret;
+    }
+
     if ((ret = pthread_create(&f->thread, NULL, input_thread, f))) {
         av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
         av_thread_message_queue_free(&f->in_thread_queue);
+        av_thread_message_queue_free(&f->pkt_recycle_queue);
         return AVERROR(ret);
     }
 
@@ -4607,9 +4624,12 @@ static int process_input(int file_index)
 
 discard_packet:
 #if HAVE_THREADS
-    if (ifile->thread_queue_size)
-        av_packet_free(&pkt);
-    else
+    if (ifile->thread_queue_size) {
+        av_packet_unref(pkt);
+        if (av_thread_message_queue_send(ifile->pkt_recycle_queue, &pkt,
+                                         AV_THREAD_MESSAGE_NONBLOCK) < 0)
+            av_packet_free(&pkt);
+    } else
 #endif
     av_packet_unref(pkt);
 
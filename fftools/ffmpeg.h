@@ -423,6 +423,7 @@ typedef struct InputFile {
 
 #if HAVE_THREADS
     AVThreadMessageQueue *in_thread_queue;
+    AVThreadMessageQueue *pkt_recycle_queue; /* consumed packets returned to the reading thread */
     pthread_t thread;           /* thread reading from this file */
     int non_blocking;           /* reading packets from the thread should not block */
     int joined;                 /* the thread has been joined */
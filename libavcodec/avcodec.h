@@ -415,6 +415,12 @@ typedef struct RcOverride{
  * Do not apply film grain, export it instead.
  */
 #define AV_CODEC_EXPORT_DATA_FILM_GRAIN (1 << 3)
+/**
+ * Encoding only.
+ * Export first pass rate control statistics through packet side data
+ * (AV_PKT_DATA_RC_STATS) instead of stats_out.
+ */
+#define AV_CODEC_EXPORT_DATA_RC_STATS   (1 << 4)
 
 /**
  * Pan Scan area.
@@ -18,6 +18,8 @@
 
 #include <string.h>
 
+#include "config.h"
+
 #include "libavutil/avassert.h"
 #include "libavutil/log.h"
 #include "libavutil/mem.h"
@@ -29,6 +31,9 @@
 #include "bsf_internal.h"
 #include "codec_desc.h"
 #include "codec_par.h"
+#if CONFIG_CBS
+#include "cbs_bsf.h"
+#endif
 
 #define IS_EMPTY(pkt) (!(pkt)->data && !(pkt)->side_data_elems)
 
@@ -270,16 +275,23 @@ typedef struct BSFListContext {
     AVBSFContext **bsfs;
     int nb_bsfs;
 
-    unsigned idx;           // index of currently processed BSF
+    // filters packets are actually sent through: bsfs without the ones
+    // fused into a preceding filter
+    AVBSFContext **chain;
+    int nb_chain;
+
+    unsigned idx;           // index of currently processed BSF in chain
 
     char * item_name;
+
+    int fuse;
 } BSFListContext;
 
 
 static int bsf_list_init(AVBSFContext *bsf)
 {
     BSFListContext *lst = bsf->priv_data;
-    int ret, i;
+    int ret, i, n;
     const AVCodecParameters *cod_par = bsf->par_in;
     AVRational tb = bsf->time_base_in;
 
@@ -298,6 +310,30 @@ static int bsf_list_init(AVBSFContext *bsf)
         tb = lst->bsfs[i]->time_base_out;
     }
 
+    lst->chain = av_malloc_array(lst->nb_bsfs, sizeof(*lst->chain));
+    if (!lst->chain) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    lst->nb_chain = 0;
+    for (i = 0; i < lst->nb_bsfs; i += n) {
+        n = 1;
+#if CONFIG_CBS
+        /* let runs of coded bitstream based filters parse and write
+         * each packet only once */
+        if (lst->fuse) {
+            while (i + n < lst->nb_bsfs &&
+                   ff_cbs_bsf_generic_can_fuse(lst->bsfs[i + n - 1],
+                                               lst->bsfs[i + n]))
+                n++;
+            ret = ff_cbs_bsf_generic_fuse(lst->bsfs + i, n);
+            if (ret < 0)
+                goto fail;
+        }
+#endif
+        lst->chain[lst->nb_chain++] = lst->bsfs[i];
+    }
+
     bsf->time_base_out = tb;
     ret = avcodec_parameters_copy(bsf->par_out, cod_par);
 
@@ -310,13 +346,13 @@ static int bsf_list_filter(AVBSFContext *bsf, AVPacket *out)
     BSFListContext *lst = bsf->priv_data;
     int ret, eof = 0;
 
-    if (!lst->nb_bsfs)
+    if (!lst->nb_chain)
         return ff_bsf_get_packet_ref(bsf, out);
 
     while (1) {
         /* get a packet from the previous filter up the chain */
         if (lst->idx)
-            ret = av_bsf_receive_packet(lst->bsfs[lst->idx-1], out);
+            ret = av_bsf_receive_packet(lst->chain[lst->idx-1], out);
         else
             ret = ff_bsf_get_packet_ref(bsf, out);
         if (ret == AVERROR(EAGAIN)) {
@@ -330,8 +366,8 @@ static int bsf_list_filter(AVBSFContext *bsf, AVPacket *out)
             return ret;
 
         /* send it to the next filter down the chain */
-        if (lst->idx < lst->nb_bsfs) {
-            ret = av_bsf_send_packet(lst->bsfs[lst->idx], eof ? NULL : out);
+        if (lst->idx < lst->nb_chain) {
+            ret = av_bsf_send_packet(lst->chain[lst->idx], eof ? NULL : out);
             av_assert1(ret != AVERROR(EAGAIN));
             if (ret < 0) {
                 av_packet_unref(out);
@@ -364,6 +400,7 @@ static void bsf_list_close(AVBSFContext *bsf)
     for (i = 0; i < lst->nb_bsfs; ++i)
         av_bsf_free(&lst->bsfs[i]);
     av_freep(&lst->bsfs);
+    av_freep(&lst->chain);
     av_freep(&lst->item_name);
 }
 
@@ -392,9 +429,18 @@ static const char *bsf_list_item_name(void *ctx)
     return lst->item_name;
 }
 
+#define OFFSET(x) offsetof(BSFListContext, x)
+#define FLAGS AV_OPT_FLAG_BSF_PARAM
+static const AVOption bsf_list_options[] = {
+    { "fuse", "share one parsed fragment between adjacent coded bitstream filters",
+        OFFSET(fuse), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, FLAGS },
+    { NULL },
+};
+
 static const AVClass bsf_list_class = {
         .class_name = "bsf_list",
         .item_name  = bsf_list_item_name,
+        .option     = bsf_list_options,
         .version    = LIBAVUTIL_VERSION_INT,
 };
 
@@ -151,6 +151,8 @@ static void cbs_unit_uninit(CodedBitstreamUnit *unit)
     unit->data             = NULL;
     unit->data_size        = 0;
     unit->data_bit_padding = 0;
+
+    unit->passthrough = 0;
 }
 
 void ff_cbs_fragment_reset(CodedBitstreamFragment *frag)
@@ -165,6 +167,8 @@ void ff_cbs_fragment_reset(CodedBitstreamFragment *frag)
     frag->data             = NULL;
     frag->data_size        = 0;
     frag->data_bit_padding = 0;
+
+    frag->passthrough = 0;
 }
 
 void ff_cbs_fragment_free(CodedBitstreamFragment *frag)
@@ -193,12 +197,15 @@ static int cbs_read_fragment_content(CodedBitstreamContext *ctx,
         }
 
         av_buffer_unref(&unit->content_ref);
-        unit->content = NULL;
+        unit->content     = NULL;
+        unit->passthrough = 0;
 
         av_assert0(unit->data && unit->data_ref);
 
         err = ctx->codec->read_unit(ctx, unit);
-        if (err == AVERROR(ENOSYS)) {
+        if (err >= 0) {
+            unit->passthrough = ctx->passthrough_unmodified;
+        } else if (err == AVERROR(ENOSYS)) {
             av_log(ctx->log_ctx, AV_LOG_VERBOSE,
                    "Decomposition unimplemented for unit %d "
                    "(type %"PRIu32").\n", i, unit->type);
@@ -358,7 +365,10 @@ static int cbs_write_unit_data(CodedBitstreamContext *ctx,
 int ff_cbs_write_fragment_data(CodedBitstreamContext *ctx,
                                CodedBitstreamFragment *frag)
 {
-    int err, i;
+    int err, i, passthrough;
+
+    passthrough = frag->passthrough && frag->data &&
+                  ctx->codec->passthrough_unit;
 
     for (i = 0; i < frag->nb_units; i++) {
         CodedBitstreamUnit *unit = &frag->units[i];
@@ -366,6 +376,19 @@ int ff_cbs_write_fragment_data(CodedBitstreamContext *ctx,
         if (!unit->content)
             continue;
 
+        if (unit->passthrough && ctx->codec->passthrough_unit) {
+            av_assert0(unit->data && unit->data_ref);
+
+            err = ctx->codec->passthrough_unit(ctx, unit);
+            if (err < 0) {
+                av_log(ctx->log_ctx, AV_LOG_ERROR, "Failed to pass through "
+                       "unit %d (type %"PRIu32").\n", i, unit->type);
+                return err;
+            }
+            continue;
+        }
+        passthrough = 0;
+
         av_buffer_unref(&unit->data_ref);
         unit->data = NULL;
 
@@ -378,6 +401,11 @@ int ff_cbs_write_fragment_data(CodedBitstreamContext *ctx,
         av_assert0(unit->data && unit->data_ref);
     }
 
+    // If no unit has changed then the bitstream the fragment was read
+    // from can be used as-is.
+    if (passthrough)
+        return 0;
+
     av_buffer_unref(&frag->data_ref);
     frag->data = NULL;
 
@@ -724,6 +752,8 @@ static int cbs_insert_unit(CodedBitstreamFragment *frag,
 
     memset(units + position, 0, sizeof(*units));
 
+    frag->passthrough = 0;
+
     if (units != frag->units) {
         av_free(frag->units);
         frag->units = units;
@@ -818,6 +848,7 @@ void ff_cbs_delete_unit(CodedBitstreamFragment *frag,
     cbs_unit_uninit(&frag->units[position]);
 
     --frag->nb_units;
+    frag->passthrough = 0;
 
     if (frag->nb_units > 0)
         memmove(frag->units + position,
@@ -1021,6 +1052,10 @@ int ff_cbs_make_unit_writable(CodedBitstreamContext *ctx,
         return err;
     av_assert0(unit->content && unit->content_ref);
 
+    // The content is about to be changed, so the bitstream it was
+    // read from can no longer be used to write it.
+    unit->passthrough = 0;
+
     if (av_buffer_is_writable(unit->content_ref))
         return 0;
 
@@ -106,6 +106,16 @@ typedef struct CodedBitstreamUnit {
      * content.  Null if content is not reference counted.
      */
     AVBufferRef *content_ref;
+
+    /**
+     * Set if data still holds the bitstream the unit was read from and
+     * content has not been changed since, so that the unit can be
+     * written by passing data through rather than by rewriting content.
+     *
+     * Only set when reading with passthrough_unmodified enabled on the
+     * context; cleared by ff_cbs_make_unit_writable().
+     */
+    int passthrough;
 } CodedBitstreamUnit;
 
 /**
@@ -162,6 +172,16 @@ typedef struct CodedBitstreamFragment {
      * Must be NULL if nb_units_allocated is zero.
      */
     CodedBitstreamUnit *units;
+
+    /**
+     * Set if data is a valid bitstream for exactly the units of this
+     * fragment, so that it can be reused as-is on write if none of the
+     * units has been modified.
+     *
+     * Set by some codecs when reading with passthrough_unmodified
+     * enabled; cleared whenever a unit is inserted or deleted.
+     */
+    int passthrough;
 } CodedBitstreamFragment;
 
 /**
@@ -202,6 +222,17 @@ typedef struct CodedBitstreamContext {
      */
     int nb_decompose_unit_types;
 
+    /**
+     * Mark units read by this context as unmodified.
+     *
+     * When a fragment read this way is written again, units still marked
+     * as such are passed through in their original bitstream form, and if
+     * the codec supports it the whole fragment bitstream is reused without
+     * any copying.  Users must call ff_cbs_make_unit_writable() on every
+     * unit before changing its content.
+     */
+    int passthrough_unmodified;
+
     /**
      * Enable trace output during read/write operations.
      */
@@ -438,6 +469,10 @@ int ff_cbs_make_unit_refcounted(CodedBitstreamContext *ctx,
  * of the content (including any internal buffers) to make a new copy,
  * and replaces the existing references inside the unit with that.
  *
+ * This also clears the passthrough flag of the unit, so it must be
+ * called before changing the content of any unit which might have been
+ * read with passthrough_unmodified set.
+ *
  * It is not valid to call this function on a unit which does not have
  * decomposed content.
  */
@@ -16,6 +16,9 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/avassert.h"
+#include "libavutil/mem.h"
+
 #include "bsf_internal.h"
 #include "cbs_bsf.h"
 
@@ -64,7 +67,8 @@ int ff_cbs_bsf_generic_filter(AVBSFContext *bsf, AVPacket *pkt)
 {
     CBSBSFContext           *ctx = bsf->priv_data;
     CodedBitstreamFragment *frag = &ctx->fragment;
-    int err;
+    CodedBitstreamContext *output = ctx->output;
+    int err, i;
 
     err = ff_bsf_get_packet_ref(bsf, pkt);
     if (err < 0)
@@ -73,6 +77,11 @@ int ff_cbs_bsf_generic_filter(AVBSFContext *bsf, AVPacket *pkt)
     err = cbs_bsf_update_side_data(bsf, pkt);
     if (err < 0)
         goto fail;
+    for (i = 0; i < ctx->nb_fused; i++) {
+        err = cbs_bsf_update_side_data(ctx->fused[i], pkt);
+        if (err < 0)
+            goto fail;
+    }
 
     err = ff_cbs_read_packet(ctx->input, frag, pkt);
     if (err < 0) {
@@ -92,7 +101,16 @@ int ff_cbs_bsf_generic_filter(AVBSFContext *bsf, AVPacket *pkt)
     if (err < 0)
         goto fail;
 
-    err = ff_cbs_write_packet(ctx->output, pkt, frag);
+    for (i = 0; i < ctx->nb_fused; i++) {
+        CBSBSFContext *next = ctx->fused[i]->priv_data;
+
+        err = next->type->update_fragment(ctx->fused[i], pkt, frag);
+        if (err < 0)
+            goto fail;
+        output = next->output;
+    }
+
+    err = ff_cbs_write_packet(output, pkt, frag);
     if (err < 0) {
         av_log(bsf, AV_LOG_ERROR, "Failed to write %s into packet.\n",
                ctx->type->fragment_name);
@@ -121,6 +139,11 @@ int ff_cbs_bsf_generic_init(AVBSFContext *bsf, const CBSBSFType *type)
     if (err < 0)
         return err;
 
+    ctx->input->decompose_unit_types    = ctx->decompose_unit_types;
+    ctx->input->nb_decompose_unit_types = ctx->nb_decompose_unit_types;
+    ctx->input->passthrough_unmodified  = type->passthrough_unmodified &&
+                                          ctx->passthrough;
+
     err = ff_cbs_init(&ctx->output, type->codec_id, bsf);
     if (err < 0)
         return err;
@@ -149,10 +172,81 @@ fail:
     return err;
 }
 
+int ff_cbs_bsf_generic_can_fuse(const AVBSFContext *bsf,
+                                const AVBSFContext *next)
+{
+    const CBSBSFContext *a = bsf->priv_data, *b = next->priv_data;
+
+    return bsf->filter->filter  == &ff_cbs_bsf_generic_filter &&
+           next->filter->filter == &ff_cbs_bsf_generic_filter &&
+           a->type->codec_id == b->type->codec_id;
+}
+
+int ff_cbs_bsf_generic_fuse(AVBSFContext **bsfs, int nb_bsfs)
+{
+    CBSBSFContext *ctx = bsfs[0]->priv_data;
+    int i, j, k, nb_types, decompose_all, passthrough;
+
+    av_assert0(!ctx->nb_fused);
+    if (nb_bsfs < 2)
+        return 0;
+
+    ctx->fused = av_malloc_array(nb_bsfs - 1, sizeof(*ctx->fused));
+    if (!ctx->fused)
+        return AVERROR(ENOMEM);
+    memcpy(ctx->fused, bsfs + 1, (nb_bsfs - 1) * sizeof(*ctx->fused));
+    ctx->nb_fused = nb_bsfs - 1;
+
+    // The shared input has to decompose everything any of the filters
+    // looks at, and can only pass units through if all of them mark the
+    // units they change.
+    decompose_all = 0;
+    passthrough   = 1;
+    nb_types      = 0;
+    for (i = 0; i < nb_bsfs; i++) {
+        const CBSBSFContext *c = bsfs[i]->priv_data;
+        if (!c->decompose_unit_types)
+            decompose_all = 1;
+        nb_types   += c->nb_decompose_unit_types;
+        passthrough = passthrough && c->type->passthrough_unmodified &&
+                      c->passthrough;
+    }
+
+    if (decompose_all) {
+        ctx->input->decompose_unit_types    = NULL;
+        ctx->input->nb_decompose_unit_types = 0;
+    } else {
+        ctx->fused_unit_types = av_malloc_array(nb_types,
+                                                sizeof(*ctx->fused_unit_types));
+        if (!ctx->fused_unit_types)
+            return AVERROR(ENOMEM);
+
+        nb_types = 0;
+        for (i = 0; i < nb_bsfs; i++) {
+            const CBSBSFContext *c = bsfs[i]->priv_data;
+            for (j = 0; j < c->nb_decompose_unit_types; j++) {
+                for (k = 0; k < nb_types; k++) {
+                    if (ctx->fused_unit_types[k] == c->decompose_unit_types[j])
+                        break;
+                }
+                if (k == nb_types)
+                    ctx->fused_unit_types[nb_types++] = c->decompose_unit_types[j];
+            }
+        }
+        ctx->input->decompose_unit_types    = ctx->fused_unit_types;
+        ctx->input->nb_decompose_unit_types = nb_types;
+    }
+    ctx->input->passthrough_unmodified = passthrough;
+
+    return 0;
+}
+
 void ff_cbs_bsf_generic_close(AVBSFContext *bsf)
 {
     CBSBSFContext *ctx = bsf->priv_data;
 
+    av_freep(&ctx->fused);
+    av_freep(&ctx->fused_unit_types);
     ff_cbs_fragment_free(&ctx->fragment);
     ff_cbs_close(&ctx->input);
     ff_cbs_close(&ctx->output);
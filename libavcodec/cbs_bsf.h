@@ -39,6 +39,13 @@ typedef struct CBSBSFType {
     // pkt is NULL, then an extradata header fragment is being updated.
     int (*update_fragment)(AVBSFContext *bsf, AVPacket *pkt,
                            CodedBitstreamFragment *frag);
+
+    // If set, units which update_fragment() does not modify can be passed
+    // through without being rewritten when the passthrough field of the
+    // context is set (see passthrough_unmodified in CodedBitstreamContext).
+    // update_fragment() must then call ff_cbs_make_unit_writable() on
+    // every unit before changing it.
+    int passthrough_unmodified;
 } CBSBSFType;
 
 // Common structure for all generic CBS BSF users.  An instance of this
@@ -51,6 +58,23 @@ typedef struct CBSBSFContext {
     CodedBitstreamContext *input;
     CodedBitstreamContext *output;
     CodedBitstreamFragment fragment;
+
+    // Unit types to decompose on input, if not all of them.  May be set
+    // before calling ff_cbs_bsf_generic_init().
+    const CodedBitstreamUnitType *decompose_unit_types;
+    int                        nb_decompose_unit_types;
+
+    // Pass units which are not modified through without rewriting them,
+    // if the type supports it.  May be set before calling
+    // ff_cbs_bsf_generic_init().
+    int passthrough;
+
+    // Filters following this one in a fused chain, whose updates are
+    // applied to the fragment before it is written; see
+    // ff_cbs_bsf_generic_fuse().  The filters themselves are not owned.
+    AVBSFContext         **fused;
+    int                 nb_fused;
+    CodedBitstreamUnitType *fused_unit_types;
 } CBSBSFContext;
 
 /**
@@ -65,6 +89,26 @@ typedef struct CBSBSFContext {
  */
 int ff_cbs_bsf_generic_init(AVBSFContext *bsf, const CBSBSFType *type);
 
+/**
+ * Check whether two initialised BSF instances can be fused.
+ *
+ * Returns nonzero if both use the generic CBS filter function on the
+ * same codec.
+ */
+int ff_cbs_bsf_generic_can_fuse(const AVBSFContext *bsf,
+                                const AVBSFContext *next);
+
+/**
+ * Fuse a chain of initialised generic CBS BSF instances.
+ *
+ * Afterwards packets sent to bsfs[0] are read once, updated by every
+ * filter of the chain in order and written once with the output context
+ * of the last filter, so only bsfs[0] should be given packets.  All
+ * filters must have been checked with ff_cbs_bsf_generic_can_fuse(),
+ * and bsfs[1..nb_bsfs-1] must outlive bsfs[0].
+ */
+int ff_cbs_bsf_generic_fuse(AVBSFContext **bsfs, int nb_bsfs);
+
 /**
  * Close a generic CBS BSF instance.
  *
@@ -656,6 +656,11 @@ static int cbs_h2645_split_fragment(CodedBitstreamContext *ctx,
         err = cbs_h2645_fragment_add_nals(ctx, frag, &priv->read_packet);
         if (err < 0)
             return err;
+
+        // An annex B fragment can be written out again unchanged if
+        // no NAL units were discarded from it.
+        frag->passthrough = ctx->passthrough_unmodified && !priv->mp4 &&
+                            frag->nb_units == priv->read_packet.nb_nals;
     }
 
     return 0;
@@ -1221,6 +1226,102 @@ static int cbs_h265_write_nal_unit(CodedBitstreamContext *ctx,
     return 0;
 }
 
+static int cbs_h264_passthrough_nal_unit(CodedBitstreamContext *ctx,
+                                         CodedBitstreamUnit *unit)
+{
+    CodedBitstreamH264Context *h264 = ctx->priv_data;
+
+    switch (unit->type) {
+    case H264_NAL_SPS:
+        return cbs_h264_replace_sps(ctx, unit);
+
+    case H264_NAL_PPS:
+        return cbs_h264_replace_pps(ctx, unit);
+
+    case H264_NAL_SLICE:
+    case H264_NAL_IDR_SLICE:
+    case H264_NAL_AUXILIARY_SLICE:
+        {
+            const H264RawSliceHeader *header =
+                &((H264RawSlice*)unit->content)->header;
+            const H264RawPPS *pps;
+            const H264RawSPS *sps;
+
+            // Activate the same parameter sets as writing the slice
+            // header would, since later units may depend on them.
+            pps = h264->pps[header->pic_parameter_set_id];
+            if (!pps)
+                return AVERROR_INVALIDDATA;
+            sps = h264->sps[pps->seq_parameter_set_id];
+            if (!sps)
+                return AVERROR_INVALIDDATA;
+
+            h264->active_pps = pps;
+            h264->active_sps = sps;
+
+            if (unit->type != H264_NAL_AUXILIARY_SLICE &&
+                !header->redundant_pic_cnt)
+                h264->last_slice_nal_unit_type = unit->type;
+        }
+        break;
+    }
+
+    return 0;
+}
+
+static int cbs_h265_passthrough_nal_unit(CodedBitstreamContext *ctx,
+                                         CodedBitstreamUnit *unit)
+{
+    CodedBitstreamH265Context *h265 = ctx->priv_data;
+
+    switch (unit->type) {
+    case HEVC_NAL_VPS:
+        return cbs_h265_replace_vps(ctx, unit);
+
+    case HEVC_NAL_SPS:
+        return cbs_h265_replace_sps(ctx, unit);
+
+    case HEVC_NAL_PPS:
+        return cbs_h265_replace_pps(ctx, unit);
+
+    case HEVC_NAL_TRAIL_N:
+    case HEVC_NAL_TRAIL_R:
+    case HEVC_NAL_TSA_N:
+    case HEVC_NAL_TSA_R:
+    case HEVC_NAL_STSA_N:
+    case HEVC_NAL_STSA_R:
+    case HEVC_NAL_RADL_N:
+    case HEVC_NAL_RADL_R:
+    case HEVC_NAL_RASL_N:
+    case HEVC_NAL_RASL_R:
+    case HEVC_NAL_BLA_W_LP:
+    case HEVC_NAL_BLA_W_RADL:
+    case HEVC_NAL_BLA_N_LP:
+    case HEVC_NAL_IDR_W_RADL:
+    case HEVC_NAL_IDR_N_LP:
+    case HEVC_NAL_CRA_NUT:
+        {
+            const H265RawSliceHeader *header =
+                &((H265RawSlice*)unit->content)->header;
+            const H265RawPPS *pps;
+            const H265RawSPS *sps;
+
+            pps = h265->pps[header->slice_pic_parameter_set_id];
+            if (!pps)
+                return AVERROR_INVALIDDATA;
+            sps = h265->sps[pps->pps_seq_parameter_set_id];
+            if (!sps)
+                return AVERROR_INVALIDDATA;
+
+            h265->active_pps = pps;
+            h265->active_sps = sps;
+        }
+        break;
+    }
+
+    return 0;
+}
+
 static int cbs_h2645_unit_requires_zero_byte(enum AVCodecID codec_id,
                                              CodedBitstreamUnitType type,
                                              int nal_unit_index)
@@ -1483,6 +1584,7 @@ const CodedBitstreamType ff_cbs_type_h264 = {
     .split_fragment    = &cbs_h2645_split_fragment,
     .read_unit         = &cbs_h264_read_nal_unit,
     .write_unit        = &cbs_h264_write_nal_unit,
+    .passthrough_unit  = &cbs_h264_passthrough_nal_unit,
     .assemble_fragment = &cbs_h2645_assemble_fragment,
 
     .flush             = &cbs_h264_flush,
@@ -1499,6 +1601,7 @@ const CodedBitstreamType ff_cbs_type_h265 = {
     .split_fragment    = &cbs_h2645_split_fragment,
     .read_unit         = &cbs_h265_read_nal_unit,
     .write_unit        = &cbs_h265_write_nal_unit,
+    .passthrough_unit  = &cbs_h265_passthrough_nal_unit,
     .assemble_fragment = &cbs_h2645_assemble_fragment,
 
     .flush             = &cbs_h265_flush,
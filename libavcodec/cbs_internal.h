@@ -118,6 +118,13 @@ typedef struct CodedBitstreamType {
                       CodedBitstreamUnit *unit,
                       PutBitContext *pbc);
 
+    // Update the internal state of a writing context for a unit which is
+    // passed through in its original bitstream form instead of being
+    // written from unit->content.  Units are only passed through if the
+    // codec implements this.
+    int (*passthrough_unit)(CodedBitstreamContext *ctx,
+                            CodedBitstreamUnit *unit);
+
     // Read the data from all of frag->units and assemble it into
     // a bitstream for the whole fragment.
     int (*assemble_fragment)(CodedBitstreamContext *ctx,
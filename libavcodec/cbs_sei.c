@@ -291,6 +291,8 @@ int ff_cbs_sei_add_message(CodedBitstreamContext *ctx,
     message->payload      = payload_data;
     message->payload_ref  = payload_ref;
 
+    unit->passthrough = 0;
+
     return 0;
 }
 
@@ -362,8 +364,10 @@ void ff_cbs_sei_delete_message_type(CodedBitstreamContext *ctx,
             continue;
 
         for (j = list->nb_messages - 1; j >= 0; j--) {
-            if (list->messages[j].payload_type == payload_type)
+            if (list->messages[j].payload_type == payload_type) {
                 cbs_sei_delete_message(list, j);
+                unit->passthrough = 0;
+            }
         }
     }
 }
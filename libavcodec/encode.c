@@ -208,7 +208,8 @@ static int encode_simple_internal(AVCodecContext *avctx, AVPacket *avpkt)
         /* This might modify frame, but it doesn't matter, because
          * the frame properties used below are not used for video
          * (due to the delay inherent in frame threaded encoding, it makes
-         *  no sense to use the properties of the current frame anyway). */
+         *  no sense to use the properties of the current frame anyway)
+         * and are set by the worker thread for audio. */
         ret = ff_thread_video_encode_frame(avctx, avpkt, frame, &got_packet);
     else {
         ret = avctx->codec->encode2(avctx, avpkt, frame, &got_packet);
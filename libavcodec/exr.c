@@ -140,6 +140,12 @@ typedef struct EXRThreadData {
     HuffEntry *he;
     uint64_t *freq;
     VLC vlc;
+
+    int use_vlc;
+    uint32_t code_base[33];
+    int code_count[33];
+    int code_offset[33];
+    uint16_t *code_sym;
 } EXRThreadData;
 
 typedef struct EXRContext {
@@ -364,6 +370,44 @@ static int huf_unpack_enc_table(GetByteContext *gb,
     return 0;
 }
 
+#define HUF_MAX_VLC_CODES 4096
+
+/**
+ * Sort the symbols by code for huf_decode_canonical(). The codes of
+ * each length are consecutive and follow the prefixes of longer codes.
+ */
+static int huf_build_canonical_table(EXRThreadData *td, int nb_codes)
+{
+    int pos[33];
+    uint32_t c = 0;
+
+    if (!td->code_sym)
+        td->code_sym = av_malloc_array(HUF_ENCSIZE, sizeof(*td->code_sym));
+    if (!td->code_sym)
+        return AVERROR(ENOMEM);
+
+    memset(td->code_count, 0, sizeof(td->code_count));
+    for (int i = 0; i < nb_codes; i++)
+        if (td->he[i].len)
+            td->code_count[td->he[i].len]++;
+
+    for (int l = 32; l > 0; l--) {
+        td->code_base[l] = c;
+        c = (c + td->code_count[l]) >> 1;
+    }
+
+    for (int l = 1, offset = 0; l <= 32; l++) {
+        td->code_offset[l] = pos[l] = offset;
+        offset += td->code_count[l];
+    }
+
+    for (int i = 0; i < nb_codes; i++)
+        if (td->he[i].len)
+            td->code_sym[pos[td->he[i].len]++] = td->he[i].sym;
+
+    return 0;
+}
+
 static int huf_build_dec_table(EXRContext *s,
                                EXRThreadData *td, int im, int iM)
 {
@@ -404,10 +448,19 @@ static int huf_build_dec_table(EXRContext *s,
     j++;
 
     ff_free_vlc(&td->vlc);
-    return ff_init_vlc_sparse(&td->vlc, 12, j,
-                              &td->he[0].len, sizeof(td->he[0]), sizeof(td->he[0].len),
-                              &td->he[0].code, sizeof(td->he[0]), sizeof(td->he[0].code),
-                              &td->he[0].sym, sizeof(td->he[0]), sizeof(td->he[0].sym), 0);
+    td->use_vlc = 0;
+    /* VLC tables are indexed with 16 bits, which is not enough when most
+     * of the 16-bit values have a code, as with noisy float channels. */
+    if (j <= HUF_MAX_VLC_CODES &&
+        ff_init_vlc_sparse(&td->vlc, 12, j,
+                           &td->he[0].len, sizeof(td->he[0]), sizeof(td->he[0].len),
+                           &td->he[0].code, sizeof(td->he[0]), sizeof(td->he[0].code),
+                           &td->he[0].sym, sizeof(td->he[0]), sizeof(td->he[0].sym), 0) >= 0) {
+        td->use_vlc = 1;
+        return 0;
+    }
+
+    return huf_build_canonical_table(td, j);
 }
 
 static int huf_decode(VLC *vlc, GetByteContext *gb, int nbits, int run_sym,
@@ -434,6 +487,46 @@ static int huf_decode(VLC *vlc, GetByteContext *gb, int nbits, int run_sym,
     return 0;
 }
 
+static int huf_decode_canonical(EXRThreadData *td, GetByteContext *gb,
+                                int nbits, int no, uint16_t *out)
+{
+    GetBitContext gbit;
+    int oe = 0;
+
+    init_get_bits(&gbit, gb->buffer, nbits);
+    while (get_bits_left(&gbit) > 0 && oe < no) {
+        uint32_t code = 0;
+        int l = 0;
+        uint16_t x;
+
+        do {
+            if (++l > 32 || get_bits_left(&gbit) <= 0)
+                return AVERROR_INVALIDDATA;
+            code = (code << 1) | get_bits1(&gbit);
+        } while (code < td->code_base[l]);
+
+        code -= td->code_base[l];
+        if (code >= td->code_count[l])
+            return AVERROR_INVALIDDATA;
+        x = td->code_sym[td->code_offset[l] + code];
+
+        if (x == td->run_sym) {
+            int run = get_bits(&gbit, 8);
+            uint16_t fill;
+
+            if (!oe || run > no - oe)
+                return AVERROR_INVALIDDATA;
+            fill = out[oe - 1];
+            while (run-- > 0)
+                out[oe++] = fill;
+        } else {
+            out[oe++] = x;
+        }
+    }
+
+    return 0;
+}
+
 static int huf_uncompress(EXRContext *s,
                           EXRThreadData *td,
                           GetByteContext *gb,
@@ -473,6 +566,8 @@ static int huf_uncompress(EXRContext *s,
 
     if ((ret = huf_build_dec_table(s, td, im, iM)) < 0)
         return ret;
+    if (!td->use_vlc)
+        return huf_decode_canonical(td, gb, nBits, dst_size, dst);
     return huf_decode(&td->vlc, gb, nBits, td->run_sym, dst_size, dst);
 }
 
@@ -2257,6 +2352,7 @@ static av_cold int decode_end(AVCodecContext *avctx)
         av_freep(&td->lut);
         av_freep(&td->he);
         av_freep(&td->freq);
+        av_freep(&td->code_sym);
         av_freep(&td->ac_data);
         av_freep(&td->dc_data);
         av_freep(&td->rle_data);
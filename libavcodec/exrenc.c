@@ -34,13 +34,27 @@
 #include "avcodec.h"
 #include "bytestream.h"
 #include "internal.h"
+#include "put_bits.h"
 #include "float2half.h"
 
+#define USHORT_RANGE (1 << 16)
+#define BITMAP_SIZE  (1 << 13)
+
+#define HUF_ENCBITS 16
+#define HUF_ENCSIZE ((1 << HUF_ENCBITS) + 1)
+#define HUF_MAXLEN  32 // longest code the decoder accepts
+
+#define SHORT_ZEROCODE_RUN 59
+#define LONG_ZEROCODE_RUN  63
+#define SHORTEST_LONG_RUN  (2 + LONG_ZEROCODE_RUN - SHORT_ZEROCODE_RUN)
+#define LONGEST_LONG_RUN   (255 + SHORTEST_LONG_RUN)
+
 enum ExrCompr {
     EXR_RAW,
     EXR_RLE,
     EXR_ZIP1,
     EXR_ZIP16,
+    EXR_PIZ,
     EXR_NBCOMPR,
 };
 
@@ -69,6 +83,15 @@ typedef struct EXRScanlineData {
     int64_t actual_size;
 } EXRScanlineData;
 
+typedef struct EXRThreadData {
+    uint8_t *bitmap;
+    uint16_t *lut;
+    uint64_t *freq;
+    uint64_t *code;
+    int *hlink;
+    int *heap;
+} EXRThreadData;
+
 typedef struct EXRContext {
     const AVClass *class;
 
@@ -83,6 +106,10 @@ typedef struct EXRContext {
     PutByteContext pb;
 
     EXRScanlineData *scanline;
+    int *scanline_ret;
+
+    EXRThreadData *thread_data;
+    int nb_thread_data;
 
     uint16_t basetable[512];
     uint8_t shifttable[512];
@@ -120,12 +147,22 @@ static int encode_init(AVCodecContext *avctx)
         s->scanline_height = 16;
         s->nb_scanlines = (avctx->height + s->scanline_height - 1) / s->scanline_height;
         break;
+    case EXR_PIZ:
+        s->scanline_height = 32;
+        s->nb_scanlines = (avctx->height + s->scanline_height - 1) / s->scanline_height;
+        break;
     default:
         av_assert0(0);
     }
 
     s->scanline = av_calloc(s->nb_scanlines, sizeof(*s->scanline));
-    if (!s->scanline)
+    s->scanline_ret = av_calloc(s->nb_scanlines, sizeof(*s->scanline_ret));
+    if (!s->scanline || !s->scanline_ret)
+        return AVERROR(ENOMEM);
+
+    s->nb_thread_data = avctx->active_thread_type & FF_THREAD_SLICE ? avctx->thread_count : 1;
+    s->thread_data = av_calloc(s->nb_thread_data, sizeof(*s->thread_data));
+    if (!s->thread_data)
         return AVERROR(ENOMEM);
 
     return 0;
@@ -144,6 +181,20 @@ static int encode_close(AVCodecContext *avctx)
     }
 
     av_freep(&s->scanline);
+    av_freep(&s->scanline_ret);
+
+    for (int i = 0; i < s->nb_thread_data && s->thread_data; i++) {
+        EXRThreadData *td = &s->thread_data[i];
+
+        av_freep(&td->bitmap);
+        av_freep(&td->lut);
+        av_freep(&td->freq);
+        av_freep(&td->code);
+        av_freep(&td->hlink);
+        av_freep(&td->heap);
+    }
+
+    av_freep(&s->thread_data);
 
     return 0;
 }
@@ -211,132 +262,565 @@ static int64_t rle_compress(uint8_t *out, int64_t out_size,
     return o;
 }
 
-static int encode_scanline_rle(EXRContext *s, const AVFrame *frame)
+static void fill_scanline(EXRContext *s, uint8_t *dst, const AVFrame *frame,
+                          int y, int scanline_height)
 {
-    const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
-
-    for (int y = 0; y < frame->height; y++) {
-        EXRScanlineData *scanline = &s->scanline[y];
-        int64_t tmp_size = element_size * s->planes * frame->width;
-        int64_t max_compressed_size = tmp_size * 3 / 2;
+    switch (s->pixel_type) {
+    case EXR_FLOAT:
+        for (int l = 0; l < scanline_height; l++) {
+            const int scanline_size = frame->width * 4 * s->planes;
 
-        av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
-        if (!scanline->uncompressed_data)
-            return AVERROR(ENOMEM);
-
-        av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
-        if (!scanline->tmp)
-            return AVERROR(ENOMEM);
-
-        av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
-        if (!scanline->compressed_data)
-            return AVERROR(ENOMEM);
-
-        switch (s->pixel_type) {
-        case EXR_FLOAT:
             for (int p = 0; p < s->planes; p++) {
                 int ch = s->ch_order[p];
 
-                memcpy(scanline->uncompressed_data + frame->width * 4 * p,
-                       frame->data[ch] + y * frame->linesize[ch], frame->width * 4);
+                memcpy(dst + scanline_size * l + p * frame->width * 4,
+                       frame->data[ch] + (y + l) * frame->linesize[ch],
+                       frame->width * 4);
             }
-            break;
-        case EXR_HALF:
+        }
+        break;
+    case EXR_HALF:
+        for (int l = 0; l < scanline_height; l++) {
+            const int scanline_size = frame->width * 2 * s->planes;
+
             for (int p = 0; p < s->planes; p++) {
                 int ch = s->ch_order[p];
-                uint16_t *dst = (uint16_t *)(scanline->uncompressed_data + frame->width * 2 * p);
-                uint32_t *src = (uint32_t *)(frame->data[ch] + y * frame->linesize[ch]);
+                uint16_t *dst16 = (uint16_t *)(dst + scanline_size * l + p * frame->width * 2);
+                uint32_t *src = (uint32_t *)(frame->data[ch] + (y + l) * frame->linesize[ch]);
 
                 for (int x = 0; x < frame->width; x++)
-                    dst[x] = float2half(src[x], s->basetable, s->shifttable);
+                    dst16[x] = float2half(src[x], s->basetable, s->shifttable);
             }
-            break;
         }
+        break;
+    }
+}
 
-        reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
-        predictor(scanline->tmp, tmp_size);
-        scanline->actual_size = rle_compress(scanline->compressed_data,
-                                             max_compressed_size,
-                                             scanline->tmp, tmp_size);
+static int encode_scanline_rle(AVCodecContext *avctx, void *arg,
+                               int y, int threadnr)
+{
+    EXRContext *s = avctx->priv_data;
+    const AVFrame *frame = arg;
+    const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
+    EXRScanlineData *scanline = &s->scanline[y];
+    int64_t tmp_size = element_size * s->planes * frame->width;
+    int64_t max_compressed_size = tmp_size * 3 / 2;
 
-        if (scanline->actual_size <= 0 || scanline->actual_size >= tmp_size) {
-            FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
-            FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
-            scanline->actual_size = tmp_size;
-        }
+    av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
+    if (!scanline->uncompressed_data)
+        return AVERROR(ENOMEM);
+
+    av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
+    if (!scanline->tmp)
+        return AVERROR(ENOMEM);
+
+    av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
+    if (!scanline->compressed_data)
+        return AVERROR(ENOMEM);
+
+    fill_scanline(s, scanline->uncompressed_data, frame, y, 1);
+
+    reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
+    predictor(scanline->tmp, tmp_size);
+    scanline->actual_size = rle_compress(scanline->compressed_data,
+                                         max_compressed_size,
+                                         scanline->tmp, tmp_size);
+
+    if (scanline->actual_size <= 0 || scanline->actual_size >= tmp_size) {
+        FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
+        FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
+        scanline->actual_size = tmp_size;
     }
 
     return 0;
 }
 
-static int encode_scanline_zip(EXRContext *s, const AVFrame *frame)
+static int encode_scanline_zip(AVCodecContext *avctx, void *arg,
+                               int y, int threadnr)
 {
+    EXRContext *s = avctx->priv_data;
+    const AVFrame *frame = arg;
     const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
+    EXRScanlineData *scanline = &s->scanline[y];
+    const int scanline_height = FFMIN(s->scanline_height, frame->height - y * s->scanline_height);
+    int64_t tmp_size = element_size * s->planes * frame->width * scanline_height;
+    int64_t max_compressed_size = tmp_size * 3 / 2;
+    unsigned long actual_size, source_size;
+
+    av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
+    if (!scanline->uncompressed_data)
+        return AVERROR(ENOMEM);
 
-    for (int y = 0; y < s->nb_scanlines; y++) {
-        EXRScanlineData *scanline = &s->scanline[y];
-        const int scanline_height = FFMIN(s->scanline_height, frame->height - y * s->scanline_height);
-        int64_t tmp_size = element_size * s->planes * frame->width * scanline_height;
-        int64_t max_compressed_size = tmp_size * 3 / 2;
-        unsigned long actual_size, source_size;
+    av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
+    if (!scanline->tmp)
+        return AVERROR(ENOMEM);
 
-        av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
-        if (!scanline->uncompressed_data)
-            return AVERROR(ENOMEM);
+    av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
+    if (!scanline->compressed_data)
+        return AVERROR(ENOMEM);
 
-        av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
-        if (!scanline->tmp)
-            return AVERROR(ENOMEM);
+    fill_scanline(s, scanline->uncompressed_data, frame,
+                  y * s->scanline_height, scanline_height);
+
+    reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
+    predictor(scanline->tmp, tmp_size);
+    source_size = tmp_size;
+    actual_size = max_compressed_size;
+    compress(scanline->compressed_data, &actual_size,
+             scanline->tmp, source_size);
+
+    scanline->actual_size = actual_size;
+    if (scanline->actual_size >= tmp_size) {
+        FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
+        FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
+        scanline->actual_size = tmp_size;
+    }
 
-        av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
-        if (!scanline->compressed_data)
-            return AVERROR(ENOMEM);
+    return 0;
+}
 
-        switch (s->pixel_type) {
-        case EXR_FLOAT:
-            for (int l = 0; l < scanline_height; l++) {
-                const int scanline_size = frame->width * 4 * s->planes;
+static inline void wenc14(uint16_t a, uint16_t b, uint16_t *l, uint16_t *h)
+{
+    int16_t as = a;
+    int16_t bs = b;
+    int16_t ms = (as + bs) >> 1;
+    int16_t ds = as - bs;
 
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
+    *l = ms;
+    *h = ds;
+}
 
-                    memcpy(scanline->uncompressed_data + scanline_size * l + p * frame->width * 4,
-                           frame->data[ch] + (y * s->scanline_height + l) * frame->linesize[ch],
-                           frame->width * 4);
+#define NBITS      16
+#define A_OFFSET  (1 << (NBITS - 1))
+#define MOD_MASK  ((1 << NBITS) - 1)
+
+static inline void wenc16(uint16_t a, uint16_t b, uint16_t *l, uint16_t *h)
+{
+    int ao = (a + A_OFFSET) & MOD_MASK;
+    int m  = (ao + b) >> 1;
+    int d  = ao - b;
+
+    if (d < 0)
+        m = (m + A_OFFSET) & MOD_MASK;
+    d &= MOD_MASK;
+
+    *l = m;
+    *h = d;
+}
+
+static void wav_encode(uint16_t *in, int nx, int ox,
+                       int ny, int oy, uint16_t mx)
+{
+    int w14 = (mx < (1 << 14));
+    int n   = (nx > ny) ? ny : nx;
+    int p   = 1;
+    int p2  = 2;
+
+    while (p2 <= n) {
+        uint16_t *py = in;
+        uint16_t *ey = in + oy * (ny - p2);
+        uint16_t i00, i01, i10, i11;
+        int oy1 = oy * p;
+        int oy2 = oy * p2;
+        int ox1 = ox * p;
+        int ox2 = ox * p2;
+
+        for (; py <= ey; py += oy2) {
+            uint16_t *px = py;
+            uint16_t *ex = py + ox * (nx - p2);
+
+            for (; px <= ex; px += ox2) {
+                uint16_t *p01 = px + ox1;
+                uint16_t *p10 = px + oy1;
+                uint16_t *p11 = p10 + ox1;
+
+                if (w14) {
+                    wenc14(*px, *p01, &i00, &i01);
+                    wenc14(*p10, *p11, &i10, &i11);
+                    wenc14(i00, i10, px, p10);
+                    wenc14(i01, i11, p01, p11);
+                } else {
+                    wenc16(*px, *p01, &i00, &i01);
+                    wenc16(*p10, *p11, &i10, &i11);
+                    wenc16(i00, i10, px, p10);
+                    wenc16(i01, i11, p01, p11);
                 }
             }
-            break;
-        case EXR_HALF:
-            for (int l = 0; l < scanline_height; l++) {
-                const int scanline_size = frame->width * 2 * s->planes;
 
-                for (int p = 0; p < s->planes; p++) {
-                    int ch = s->ch_order[p];
-                    uint16_t *dst = (uint16_t *)(scanline->uncompressed_data + scanline_size * l + p * frame->width * 2);
-                    uint32_t *src = (uint32_t *)(frame->data[ch] + (y * s->scanline_height + l) * frame->linesize[ch]);
+            if (nx & p) {
+                uint16_t *p10 = px + oy1;
 
-                    for (int x = 0; x < frame->width; x++)
-                        dst[x] = float2half(src[x], s->basetable, s->shifttable);
-                }
+                if (w14)
+                    wenc14(*px, *p10, &i00, p10);
+                else
+                    wenc16(*px, *p10, &i00, p10);
+
+                *px = i00;
             }
-            break;
         }
 
-        reorder_pixels(scanline->tmp, scanline->uncompressed_data, tmp_size);
-        predictor(scanline->tmp, tmp_size);
-        source_size = tmp_size;
-        actual_size = max_compressed_size;
-        compress(scanline->compressed_data, &actual_size,
-                 scanline->tmp, source_size);
-
-        scanline->actual_size = actual_size;
-        if (scanline->actual_size >= tmp_size) {
-            FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
-            FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
-            scanline->actual_size = tmp_size;
+        if (ny & p) {
+            uint16_t *px = py;
+            uint16_t *ex = py + ox * (nx - p2);
+
+            for (; px <= ex; px += ox2) {
+                uint16_t *p01 = px + ox1;
+
+                if (w14)
+                    wenc14(*px, *p01, &i00, p01);
+                else
+                    wenc16(*px, *p01, &i00, p01);
+
+                *px = i00;
+            }
+        }
+
+        p   = p2;
+        p2 <<= 1;
+    }
+}
+
+static void huf_canonical_code_table(uint64_t *freq)
+{
+    uint64_t c, n[HUF_MAXLEN + 1] = { 0 };
+    int i;
+
+    for (i = 0; i < HUF_ENCSIZE; i++)
+        n[freq[i]] += 1;
+
+    c = 0;
+    for (i = HUF_MAXLEN; i > 0; --i) {
+        uint64_t nc = ((c + n[i]) >> 1);
+        n[i] = c;
+        c    = nc;
+    }
+
+    for (i = 0; i < HUF_ENCSIZE; ++i) {
+        int l = freq[i];
+
+        if (l > 0)
+            freq[i] = l | (n[l]++ << 6);
+    }
+}
+
+static void heap_sift_down(int *heap, int nb, int i, const uint64_t *freq)
+{
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+
+        if (l < nb && (freq[heap[l]] < freq[heap[m]] ||
+                       (freq[heap[l]] == freq[heap[m]] && heap[l] < heap[m])))
+            m = l;
+        if (r < nb && (freq[heap[r]] < freq[heap[m]] ||
+                       (freq[heap[r]] == freq[heap[m]] && heap[r] < heap[m])))
+            m = r;
+        if (m == i)
+            return;
+        FFSWAP(int, heap[i], heap[m]);
+        i = m;
+    }
+}
+
+/**
+ * Turn the symbol counts in td->freq into canonical codes in td->code,
+ * stored as (code << 6) | length like the decoder expects.
+ * The symbol following the last used one is the run-length code.
+ * @return 0, or -1 if a code would be longer than HUF_MAXLEN
+ */
+static int huf_build_enc_table(EXRThreadData *td, int *im, int *iM)
+{
+    uint64_t *freq = td->freq;
+    uint64_t *code = td->code;
+    int *hlink = td->hlink;
+    int *heap = td->heap;
+    int nb = 0;
+
+    *im = 0;
+    while (!freq[*im])
+        (*im)++;
+
+    *iM = *im;
+    for (int i = *im; i < HUF_ENCSIZE; i++) {
+        hlink[i] = i;
+        if (freq[i]) {
+            heap[nb++] = i;
+            *iM = i;
+        }
+    }
+
+    (*iM)++;
+    freq[*iM] = 1;
+    heap[nb++] = *iM;
+
+    memset(code, 0, HUF_ENCSIZE * sizeof(*code));
+
+    for (int i = nb / 2 - 1; i >= 0; i--)
+        heap_sift_down(heap, nb, i, freq);
+
+    while (nb > 1) {
+        int mm = heap[0], m, j;
+
+        heap[0] = heap[--nb];
+        heap_sift_down(heap, nb, 0, freq);
+        m = heap[0];
+        freq[m] += freq[mm];
+        heap_sift_down(heap, nb, 0, freq);
+
+        /* Lengthen the codes of both merged subtrees and join their lists. */
+        for (j = m; ; j = hlink[j]) {
+            code[j]++;
+            if (hlink[j] == j) {
+                hlink[j] = mm;
+                break;
+            }
+        }
+
+        for (j = mm; ; j = hlink[j]) {
+            code[j]++;
+            if (hlink[j] == j)
+                break;
+        }
+    }
+
+    for (int i = *im; i <= *iM; i++)
+        if (code[i] > HUF_MAXLEN)
+            return -1;
+
+    huf_canonical_code_table(code);
+    return 0;
+}
+
+static void huf_pack_enc_table(PutBitContext *pb, const uint64_t *code,
+                               int im, int iM)
+{
+    for (; im <= iM; im++) {
+        int l = code[im] & 63;
+
+        if (l == 0) {
+            int zerun = 1;
+
+            while (im < iM && zerun < LONGEST_LONG_RUN) {
+                if (code[im + 1] & 63)
+                    break;
+                im++;
+                zerun++;
+            }
+
+            if (zerun >= SHORTEST_LONG_RUN) {
+                put_bits(pb, 6, LONG_ZEROCODE_RUN);
+                put_bits(pb, 8, zerun - SHORTEST_LONG_RUN);
+                continue;
+            } else if (zerun >= 2) {
+                put_bits(pb, 6, SHORT_ZEROCODE_RUN + zerun - 2);
+                continue;
+            }
+        }
+
+        put_bits(pb, 6, l);
+    }
+}
+
+static void huf_send_code(PutBitContext *pb, uint64_t scode, int run,
+                          uint64_t rcode)
+{
+    int slen = scode & 63;
+    int rlen = rcode & 63;
+
+    if (slen + rlen + 8 < slen * run) {
+        put_bits64(pb, slen, scode >> 6);
+        put_bits64(pb, rlen, rcode >> 6);
+        put_bits(pb, 8, run);
+    } else {
+        while (run-- >= 0)
+            put_bits64(pb, slen, scode >> 6);
+    }
+}
+
+static int huf_encode(PutBitContext *pb, const uint64_t *code,
+                      const uint16_t *in, int nb, int run_sym)
+{
+    int sym = in[0], run = 0;
+
+    for (int i = 1; i < nb; i++) {
+        if (sym == in[i] && run < 255) {
+            run++;
+        } else {
+            /* a single call writes at most 3 * HUF_MAXLEN + 8 bits */
+            if (put_bits_left(pb) < 192)
+                return -1;
+            huf_send_code(pb, code[sym], run, code[run_sym]);
+            run = 0;
+        }
+        sym = in[i];
+    }
+
+    if (put_bits_left(pb) < 192)
+        return -1;
+    huf_send_code(pb, code[sym], run, code[run_sym]);
+
+    return put_bits_count(pb);
+}
+
+/**
+ * Compress one block of channel-planar 16-bit words: range reduction
+ * through a bitmap and lookup table, a wavelet transform per channel
+ * and Huffman coding, the inverse of piz_uncompress() in exr.c.
+ * @return compressed size, or -1 if it does not fit in out_size
+ */
+static int64_t piz_compress(EXRContext *s, EXRThreadData *td,
+                            uint8_t *out, int64_t out_size,
+                            uint16_t *tmp, int nb, int width, int height)
+{
+    const int pixel_half_size = s->pixel_type == EXR_HALF ? 1 : 2;
+    uint16_t min_non_zero = BITMAP_SIZE - 1, max_non_zero = 0, maxval;
+    uint8_t *huf, *table, *end = out + out_size;
+    PutByteContext pbc;
+    PutBitContext pb;
+    uint16_t *ptr = tmp;
+    int im, iM, table_size, nb_bits, k = 0;
+
+    memset(td->bitmap, 0, BITMAP_SIZE);
+    for (int i = 0; i < nb; i++)
+        td->bitmap[tmp[i] >> 3] |= 1 << (tmp[i] & 7);
+    td->bitmap[0] &= ~1;
+
+    for (int i = 0; i < BITMAP_SIZE; i++) {
+        if (td->bitmap[i]) {
+            if (min_non_zero > i)
+                min_non_zero = i;
+            max_non_zero = i;
+        }
+    }
+
+    for (int i = 0; i < USHORT_RANGE; i++)
+        td->lut[i] = (i == 0 || (td->bitmap[i >> 3] & (1 << (i & 7)))) ? k++ : 0;
+    maxval = k - 1;
+
+    for (int i = 0; i < nb; i++)
+        tmp[i] = td->lut[tmp[i]];
+
+    for (int p = 0; p < s->planes; p++) {
+        for (int j = 0; j < pixel_half_size; j++)
+            wav_encode(ptr + j, width, pixel_half_size, height,
+                       width * pixel_half_size, maxval);
+        ptr += width * height * pixel_half_size;
+    }
+
+    /* Flatten the distribution until no code is too long to decode. */
+    for (int shift = 0; ; shift++) {
+        memset(td->freq, 0, HUF_ENCSIZE * sizeof(*td->freq));
+        for (int i = 0; i < nb; i++)
+            td->freq[tmp[i]]++;
+        if (shift)
+            for (int i = 0; i < HUF_ENCSIZE; i++)
+                if (td->freq[i])
+                    td->freq[i] = FFMAX(td->freq[i] >> shift, 1);
+        if (!huf_build_enc_table(td, &im, &iM))
+            break;
+    }
+
+    bytestream2_init_writer(&pbc, out, out_size);
+    bytestream2_put_le16(&pbc, min_non_zero);
+    bytestream2_put_le16(&pbc, max_non_zero);
+    if (min_non_zero <= max_non_zero)
+        bytestream2_put_buffer(&pbc, td->bitmap + min_non_zero,
+                               max_non_zero - min_non_zero + 1);
+    bytestream2_skip_p(&pbc, 4 + 20);
+    if (bytestream2_get_eof(&pbc))
+        return -1;
+
+    huf   = out + bytestream2_tell_p(&pbc) - 20;
+    table = out + bytestream2_tell_p(&pbc);
+
+    /* the table needs at most 6 bits per symbol */
+    if (end - table < (iM - im + 1) * 6 / 8 + 8)
+        return -1;
+    init_put_bits(&pb, table, end - table);
+    huf_pack_enc_table(&pb, td->code, im, iM);
+    flush_put_bits(&pb);
+    table_size = put_bits_count(&pb) >> 3;
+
+    init_put_bits(&pb, table + table_size, end - table - table_size);
+    nb_bits = huf_encode(&pb, td->code, tmp, nb, iM);
+    if (nb_bits < 0)
+        return -1;
+    flush_put_bits(&pb);
+
+    AV_WL32(huf - 4,  20 + table_size + put_bits_count(&pb) / 8);
+    AV_WL32(huf,      im);
+    AV_WL32(huf + 4,  iM);
+    AV_WL32(huf + 8,  table_size);
+    AV_WL32(huf + 12, nb_bits);
+    AV_WL32(huf + 16, 0);
+
+    return table + table_size + put_bits_count(&pb) / 8 - out;
+}
+
+static int encode_scanline_piz(AVCodecContext *avctx, void *arg,
+                               int y, int threadnr)
+{
+    EXRContext *s = avctx->priv_data;
+    EXRThreadData *td = &s->thread_data[threadnr];
+    const AVFrame *frame = arg;
+    const int64_t element_size = s->pixel_type == EXR_HALF ? 2LL : 4LL;
+    EXRScanlineData *scanline = &s->scanline[y];
+    const int scanline_height = FFMIN(s->scanline_height, frame->height - y * s->scanline_height);
+    const int64_t line_size = element_size * frame->width;
+    int64_t tmp_size = line_size * s->planes * scanline_height;
+    int64_t max_compressed_size = tmp_size;
+
+    av_fast_padded_malloc(&scanline->uncompressed_data, &scanline->uncompressed_size, tmp_size);
+    if (!scanline->uncompressed_data)
+        return AVERROR(ENOMEM);
+
+    av_fast_padded_malloc(&scanline->tmp, &scanline->tmp_size, tmp_size);
+    if (!scanline->tmp)
+        return AVERROR(ENOMEM);
+
+    av_fast_padded_malloc(&scanline->compressed_data, &scanline->compressed_size, max_compressed_size);
+    if (!scanline->compressed_data)
+        return AVERROR(ENOMEM);
+
+    if (!td->bitmap)
+        td->bitmap = av_malloc(BITMAP_SIZE);
+    if (!td->lut)
+        td->lut = av_malloc(USHORT_RANGE * sizeof(*td->lut));
+    if (!td->freq)
+        td->freq = av_malloc_array(HUF_ENCSIZE, sizeof(*td->freq));
+    if (!td->code)
+        td->code = av_malloc_array(HUF_ENCSIZE, sizeof(*td->code));
+    if (!td->hlink)
+        td->hlink = av_malloc_array(HUF_ENCSIZE, sizeof(*td->hlink));
+    if (!td->heap)
+        td->heap = av_malloc_array(HUF_ENCSIZE, sizeof(*td->heap));
+    if (!td->bitmap || !td->lut || !td->freq || !td->code ||
+        !td->hlink || !td->heap)
+        return AVERROR(ENOMEM);
+
+    fill_scanline(s, scanline->uncompressed_data, frame,
+                  y * s->scanline_height, scanline_height);
+
+    /* PIZ works on whole channels: gather the lines of each channel. */
+    for (int l = 0; l < scanline_height; l++) {
+        for (int p = 0; p < s->planes; p++) {
+            memcpy(scanline->tmp + (p * scanline_height + l) * line_size,
+                   scanline->uncompressed_data + (l * s->planes + p) * line_size,
+                   line_size);
         }
     }
 
+    scanline->actual_size = piz_compress(s, td, scanline->compressed_data,
+                                         max_compressed_size,
+                                         (uint16_t *)scanline->tmp,
+                                         tmp_size / 2, frame->width,
+                                         scanline_height);
+
+    if (scanline->actual_size <= 0 || scanline->actual_size >= tmp_size) {
+        FFSWAP(uint8_t *, scanline->uncompressed_data, scanline->compressed_data);
+        FFSWAP(int, scanline->uncompressed_size, scanline->compressed_size);
+        scanline->actual_size = tmp_size;
+    }
+
     return 0;
 }
 
@@ -430,16 +914,25 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
         /* nothing to do */
         break;
     case EXR_RLE:
-        encode_scanline_rle(s, frame);
+        avctx->execute2(avctx, encode_scanline_rle, (void *)frame, s->scanline_ret, s->nb_scanlines);
         break;
     case EXR_ZIP16:
     case EXR_ZIP1:
-        encode_scanline_zip(s, frame);
+        avctx->execute2(avctx, encode_scanline_zip, (void *)frame, s->scanline_ret, s->nb_scanlines);
+        break;
+    case EXR_PIZ:
+        avctx->execute2(avctx, encode_scanline_piz, (void *)frame, s->scanline_ret, s->nb_scanlines);
         break;
     default:
         av_assert0(0);
     }
 
+    if (s->compression != EXR_RAW) {
+        for (int y = 0; y < s->nb_scanlines; y++)
+            if (s->scanline_ret[y] < 0)
+                return s->scanline_ret[y];
+    }
+
     switch (s->compression) {
     case EXR_RAW:
         offset = bytestream2_tell_p(pb) + avctx->height * 8LL;
@@ -479,6 +972,7 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
             }
         }
         break;
+    case EXR_PIZ:
     case EXR_ZIP16:
     case EXR_ZIP1:
     case EXR_RLE:
@@ -520,6 +1014,7 @@ static const AVOption options[] = {
     { "rle" ,        "RLE",                  0,                   AV_OPT_TYPE_CONST, {.i64=EXR_RLE}, 0, 0, VE, "compr" },
     { "zip1",        "ZIP1",                 0,                   AV_OPT_TYPE_CONST, {.i64=EXR_ZIP1}, 0, 0, VE, "compr" },
     { "zip16",       "ZIP16",                0,                   AV_OPT_TYPE_CONST, {.i64=EXR_ZIP16}, 0, 0, VE, "compr" },
+    { "piz",         "PIZ",                  0,                   AV_OPT_TYPE_CONST, {.i64=EXR_PIZ}, 0, 0, VE, "compr" },
     { "format", "set pixel type", OFFSET(pixel_type), AV_OPT_TYPE_INT,   {.i64=EXR_FLOAT}, EXR_HALF, EXR_UNKNOWN-1, VE, "pixel" },
     { "half" ,       NULL,                   0,                   AV_OPT_TYPE_CONST, {.i64=EXR_HALF},  0, 0, VE, "pixel" },
     { "float",       NULL,                   0,                   AV_OPT_TYPE_CONST, {.i64=EXR_FLOAT}, 0, 0, VE, "pixel" },
@@ -544,7 +1039,7 @@ AVCodec ff_exr_encoder = {
     .init           = encode_init,
     .encode2        = encode_frame,
     .close          = encode_close,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
                                                  AV_PIX_FMT_GBRPF32,
                                                  AV_PIX_FMT_GBRAPF32,
@@ -40,6 +40,7 @@
 typedef struct{
     AVFrame  *indata;
     AVPacket *outdata;
+    int       frame_number;
     int       return_code;
     int       finished;
 } Task;
@@ -94,12 +95,24 @@ static void * attribute_align_arg worker(void *v){
         frame = task->indata;
         pkt   = task->outdata;
 
+        /* Encoders may derive bitstream fields (e.g. block sample offsets)
+         * from the frame number, which the worker contexts do not track. */
+        avctx->frame_number = task->frame_number;
+
         ret = avctx->codec->encode2(avctx, pkt, frame, &got_packet);
         if(got_packet) {
             int ret2 = av_packet_make_refcounted(pkt);
             if (ret >= 0 && ret2 < 0)
                 ret = ret2;
-            pkt->pts = pkt->dts = frame->pts;
+            if (avctx->codec->type == AVMEDIA_TYPE_AUDIO) {
+                /* The caller no longer has the frame, so set the audio
+                 * timestamps here, as encode_simple_internal() would. */
+                if (pkt->pts == AV_NOPTS_VALUE)
+                    pkt->pts = frame->pts;
+                if (!pkt->duration)
+                    pkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
+            } else
+                pkt->pts = pkt->dts = frame->pts;
         } else {
             pkt->data = NULL;
             pkt->size = 0;
@@ -169,6 +182,26 @@ int ff_frame_thread_encoder_init(AVCodecContext *avctx, AVDictionary *options){
         }
     }
 
+    if (avctx->codec_id == AV_CODEC_ID_FFV1 &&
+        (avctx->gop_size > 1 || avctx->flags & AV_CODEC_FLAG_PASS1)) {
+        // non-intra ffv1 carries the context state from frame to frame,
+        // leave it to slice threading
+        av_log(avctx, AV_LOG_VERBOSE,
+               "Not using frame threads for ffv1 encoding with first pass or "
+               "a GOP size above 1, use -g 1 if you want them\n");
+        return 0;
+    }
+
+    if (avctx->codec_id == AV_CODEC_ID_WAVPACK &&
+        avctx->compression_level < 3) {
+        // below level 3 the decorrelation search and weights carry over
+        // from block to block, restarting them per frame costs a lot of size
+        av_log(avctx, AV_LOG_VERBOSE,
+               "Not using frame threads for wavpack encoding below "
+               "compression level 3\n");
+        return 0;
+    }
+
     if(!avctx->thread_count) {
         avctx->thread_count = av_cpu_count();
         avctx->thread_count = FFMIN(avctx->thread_count, MAX_THREADS);
@@ -284,6 +317,7 @@ int ff_thread_video_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     av_assert1(!*got_packet_ptr);
 
     if(frame){
+        c->tasks[c->task_index].frame_number = avctx->frame_number;
         av_frame_move_ref(c->tasks[c->task_index].indata, frame);
 
         pthread_mutex_lock(&c->task_fifo_mutex);
@@ -31,6 +31,7 @@
  */
 
 #define BITSTREAM_WRITER_LE
+#include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/imgutils.h"
 #include "avcodec.h"
@@ -43,12 +44,27 @@
 
 #define DEFAULT_TRANSPARENCY_INDEX 0x1f
 
-typedef struct GIFContext {
-    const AVClass *class;
+typedef struct GIFThreadData {
     LZWState *lzw;
     uint8_t *buf;
     uint8_t *shrunk_buf;
-    int buf_size;
+    uint8_t *tmpl;                      ///< temporary line buffer
+} GIFThreadData;
+
+typedef struct GIFJob {
+    AVFrame *frame;
+    AVFrame *last_frame;                ///< previous input frame, if it is referenced
+    const uint32_t *palette;            ///< palette of a pal8 frame, NULL if unchanged
+    int64_t frame_number;
+    uint8_t *outbuf;                    ///< coded image
+    int size;
+} GIFJob;
+
+typedef struct GIFContext {
+    const AVClass *class;
+    GIFThreadData *td;
+    int nb_td;
+    int buf_size, outbuf_size;
     AVFrame *last_frame;
     int flags;
     int image;
@@ -56,7 +72,15 @@ typedef struct GIFContext {
     uint32_t palette[AVPALETTE_COUNT];  ///< local reference palette for !pal8
     int palette_loaded;
     int transparent_index;
-    uint8_t *tmpl;                      ///< temporary line buffer
+
+    /**
+     * Frames are encoded max_jobs at a time, the ring holds one more slot
+     * for the frame arriving while the last packet of a batch is returned.
+     */
+    GIFJob *jobs;
+    int *job_ret;                       ///< return values of the jobs of a batch
+    int max_jobs, nb_slots;
+    int first_job, nb_done, nb_queued;
 } GIFContext;
 
 enum {
@@ -96,6 +120,63 @@ static void remap_frame_to_palette(const uint8_t *src, int src_linesize,
             dst[i * dst_linesize + j] = map[src[i * src_linesize + j]];
 }
 
+/**
+ * @return the index of the first byte in which a and b differ, n if none
+ */
+static int first_diff(const uint8_t *a, const uint8_t *b, int n)
+{
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8)
+        if (AV_RN64(a + i) != AV_RN64(b + i))
+            break;
+    for (; i < n; i++)
+        if (a[i] != b[i])
+            break;
+    return i;
+}
+
+/**
+ * @return the index of the last byte in which a and b differ, -1 if none
+ */
+static int last_diff(const uint8_t *a, const uint8_t *b, int n)
+{
+    int i = n;
+
+    for (; i >= 8; i -= 8)
+        if (AV_RN64(a + i - 8) != AV_RN64(b + i - 8))
+            break;
+    while (--i >= 0)
+        if (a[i] != b[i])
+            break;
+    return i;
+}
+
+/**
+ * Set [*x_start, *x_end] to the columns between 0 and *x_end in which
+ * lines y_start to y_end - 1 of buf differ from ref. The lines are scanned
+ * one at a time instead of walking down each column. If no line differs,
+ * *x_start is set to *x_end.
+ */
+static void crop_columns(const uint8_t *buf, int linesize,
+                         const uint8_t *ref, int ref_linesize,
+                         int y_start, int y_end, int *x_start, int *x_end)
+{
+    const int w = *x_end + 1;
+    int left = *x_end, right = -1;
+
+    for (int y = y_start; y < y_end && (left || right < w - 1); y++) {
+        const uint8_t *a = buf + y * linesize;
+        const uint8_t *b = ref + y * ref_linesize;
+
+        left   = first_diff(a, b, left);
+        right += 1 + last_diff(a + right + 1, b + right + 1, w - right - 1);
+    }
+
+    *x_start = left;
+    *x_end   = FFMAX(left, right);
+}
+
 static int is_image_translucent(AVCodecContext *avctx,
                                 const uint8_t *buf, const int linesize)
 {
@@ -106,11 +187,8 @@ static int is_image_translucent(AVCodecContext *avctx,
         return 0;
 
     for (int y = 0; y < avctx->height; y++) {
-        for (int x = 0; x < avctx->width; x++) {
-            if (buf[x] == trans) {
-                return 1;
-            }
-        }
+        if (memchr(buf, trans, avctx->width))
+            return 1;
         buf += linesize;
     }
 
@@ -151,7 +229,7 @@ static int pick_palette_entry(const uint8_t *buf, int linesize, int w, int h)
     return -1;
 }
 
-static void gif_crop_translucent(AVCodecContext *avctx,
+static void gif_crop_translucent(AVCodecContext *avctx, GIFThreadData *td,
                                  const uint8_t *buf, const int linesize,
                                  int *width, int *height,
                                  int *x_start, int *y_start)
@@ -163,65 +241,29 @@ static void gif_crop_translucent(AVCodecContext *avctx,
     if ((s->flags & GF_OFFSETTING) && trans >= 0) {
         const int w = avctx->width;
         const int h = avctx->height;
+        const uint8_t *trans_line = td->tmpl;
         int x_end = w - 1,
             y_end = h - 1;
 
+        memset(td->tmpl, trans, w);
+
         // crop top
         while (*y_start < y_end) {
-            int is_trans = 1;
-            for (int i = 0; i < w; i++) {
-                if (buf[linesize * *y_start + i] != trans) {
-                    is_trans = 0;
-                    break;
-                }
-            }
-
-            if (!is_trans)
+            if (memcmp(trans_line, buf + linesize * *y_start, w))
                 break;
             (*y_start)++;
         }
 
         // crop bottom
         while (y_end > *y_start) {
-            int is_trans = 1;
-            for (int i = 0; i < w; i++) {
-                if (buf[linesize * y_end + i] != trans) {
-                    is_trans = 0;
-                    break;
-                }
-            }
-            if (!is_trans)
+            if (memcmp(trans_line, buf + linesize * y_end, w))
                 break;
             y_end--;
         }
 
-        // crop left
-        while (*x_start < x_end) {
-            int is_trans = 1;
-            for (int i = *y_start; i < y_end; i++) {
-                if (buf[linesize * i + *x_start] != trans) {
-                    is_trans = 0;
-                    break;
-                }
-            }
-            if (!is_trans)
-                break;
-            (*x_start)++;
-        }
-
-        // crop right
-        while (x_end > *x_start) {
-            int is_trans = 1;
-            for (int i = *y_start; i < y_end; i++) {
-                if (buf[linesize * i + x_end] != trans) {
-                    is_trans = 0;
-                    break;
-                }
-            }
-            if (!is_trans)
-                break;
-            x_end--;
-        }
+        // crop left and right
+        crop_columns(buf, linesize, trans_line, 0,
+                     *y_start, y_end, x_start, &x_end);
 
         *height = y_end + 1 - *y_start;
         *width  = x_end + 1 - *x_start;
@@ -231,16 +273,16 @@ static void gif_crop_translucent(AVCodecContext *avctx,
 }
 
 static void gif_crop_opaque(AVCodecContext *avctx,
-                            const uint32_t *palette,
+                            const AVFrame *last_frame, const uint32_t *palette,
                             const uint8_t *buf, const int linesize,
                             int *width, int *height, int *x_start, int *y_start)
 {
     GIFContext *s = avctx->priv_data;
 
     /* Crop image */
-    if ((s->flags & GF_OFFSETTING) && s->last_frame && !palette) {
-        const uint8_t *ref = s->last_frame->data[0];
-        const int ref_linesize = s->last_frame->linesize[0];
+    if ((s->flags & GF_OFFSETTING) && last_frame && !palette) {
+        const uint8_t *ref = last_frame->data[0];
+        const int ref_linesize = last_frame->linesize[0];
         int x_end = avctx->width  - 1,
             y_end = avctx->height - 1;
 
@@ -258,30 +300,8 @@ static void gif_crop_opaque(AVCodecContext *avctx,
         *height = y_end + 1 - *y_start;
 
         /* skip common columns */
-        while (*x_start < x_end) {
-            int same_column = 1;
-            for (int y = *y_start; y <= y_end; y++) {
-                if (ref[y*ref_linesize + *x_start] != buf[y*linesize + *x_start]) {
-                    same_column = 0;
-                    break;
-                }
-            }
-            if (!same_column)
-                break;
-            (*x_start)++;
-        }
-        while (x_end > *x_start) {
-            int same_column = 1;
-            for (int y = *y_start; y <= y_end; y++) {
-                if (ref[y*ref_linesize + x_end] != buf[y*linesize + x_end]) {
-                    same_column = 0;
-                    break;
-                }
-            }
-            if (!same_column)
-                break;
-            x_end--;
-        }
+        crop_columns(buf, linesize, ref, ref_linesize,
+                     *y_start, y_end + 1, x_start, &x_end);
         *width = x_end + 1 - *x_start;
 
         av_log(avctx, AV_LOG_DEBUG,"%dx%d image at pos (%d;%d) [area:%dx%d]\n",
@@ -289,16 +309,16 @@ static void gif_crop_opaque(AVCodecContext *avctx,
     }
 }
 
-static int gif_image_write_image(AVCodecContext *avctx,
+static int gif_image_write_image(AVCodecContext *avctx, GIFThreadData *td,
                                  uint8_t **bytestream, uint8_t *end,
+                                 const AVFrame *last_frame, int64_t frame_number,
                                  const uint32_t *palette,
-                                 const uint8_t *buf, const int linesize,
-                                 AVPacket *pkt)
+                                 const uint8_t *buf, const int linesize)
 {
     GIFContext *s = avctx->priv_data;
     int disposal, len = 0, height = avctx->height, width = avctx->width, x, y;
     int x_start = 0, y_start = 0, trans = s->transparent_index;
-    int bcid = -1, honor_transparency = (s->flags & GF_TRANSDIFF) && s->last_frame && !palette;
+    int bcid = -1, honor_transparency = (s->flags & GF_TRANSDIFF) && last_frame && !palette;
     const uint8_t *ptr;
     uint32_t shrunk_palette[AVPALETTE_COUNT];
     uint8_t map[AVPALETTE_COUNT] = { 0 };
@@ -313,15 +333,15 @@ static int gif_image_write_image(AVCodecContext *avctx,
     memset(shrunk_palette, 0xff, AVPALETTE_SIZE);
 
     if (!s->image && is_image_translucent(avctx, buf, linesize)) {
-        gif_crop_translucent(avctx, buf, linesize, &width, &height, &x_start, &y_start);
+        gif_crop_translucent(avctx, td, buf, linesize, &width, &height, &x_start, &y_start);
         honor_transparency = 0;
         disposal = GCE_DISPOSAL_BACKGROUND;
     } else {
-        gif_crop_opaque(avctx, palette, buf, linesize, &width, &height, &x_start, &y_start);
+        gif_crop_opaque(avctx, last_frame, palette, buf, linesize, &width, &height, &x_start, &y_start);
         disposal = GCE_DISPOSAL_INPLACE;
     }
 
-    if (s->image || !avctx->frame_number) { /* GIF header */
+    if (s->image || !frame_number) { /* GIF header */
         const uint32_t *global_palette = palette ? palette : s->palette;
         const AVRational sar = avctx->sample_aspect_ratio;
         int64_t aspect = 0;
@@ -397,49 +417,51 @@ static int gif_image_write_image(AVCodecContext *avctx,
 
     bytestream_put_byte(bytestream, 0x08);
 
-    ff_lzw_encode_init(s->lzw, s->buf, s->buf_size,
+    ff_lzw_encode_init(td->lzw, td->buf, s->buf_size,
                        12, FF_LZW_GIF, 1);
 
     if (shrunk_palette_count) {
-        if (!s->shrunk_buf) {
-            s->shrunk_buf = av_malloc(avctx->height * linesize);
-            if (!s->shrunk_buf) {
+        if (!td->shrunk_buf) {
+            td->shrunk_buf = av_malloc(avctx->height * linesize);
+            if (!td->shrunk_buf) {
                 av_log(avctx, AV_LOG_ERROR, "Could not allocated remapped frame buffer.\n");
                 return AVERROR(ENOMEM);
             }
         }
-        remap_frame_to_palette(buf, linesize, s->shrunk_buf, linesize, avctx->width, avctx->height, map);
-        ptr = s->shrunk_buf + y_start*linesize + x_start;
+        remap_frame_to_palette(buf + y_start*linesize + x_start, linesize,
+                               td->shrunk_buf + y_start*linesize + x_start, linesize,
+                               width, height, map);
+        ptr = td->shrunk_buf + y_start*linesize + x_start;
     } else {
         ptr = buf + y_start*linesize + x_start;
     }
     if (honor_transparency) {
-        const int ref_linesize = s->last_frame->linesize[0];
-        const uint8_t *ref = s->last_frame->data[0] + y_start*ref_linesize + x_start;
+        const int ref_linesize = last_frame->linesize[0];
+        const uint8_t *ref = last_frame->data[0] + y_start*ref_linesize + x_start;
 
         for (y = 0; y < height; y++) {
-            memcpy(s->tmpl, ptr, width);
+            memcpy(td->tmpl, ptr, width);
             for (x = 0; x < width; x++)
                 if (ref[x] == ptr[x])
-                    s->tmpl[x] = trans;
-            len += ff_lzw_encode(s->lzw, s->tmpl, width);
+                    td->tmpl[x] = trans;
+            len += ff_lzw_encode(td->lzw, td->tmpl, width);
             ptr += linesize;
             ref += ref_linesize;
         }
     } else {
         for (y = 0; y < height; y++) {
-            len += ff_lzw_encode(s->lzw, ptr, width);
+            len += ff_lzw_encode(td->lzw, ptr, width);
             ptr += linesize;
         }
     }
-    len += ff_lzw_encode_flush(s->lzw);
+    len += ff_lzw_encode_flush(td->lzw);
 
-    ptr = s->buf;
+    ptr = td->buf;
     while (len > 0) {
         int size = FFMIN(255, len);
         bytestream_put_byte(bytestream, size);
         if (end - *bytestream < size)
-            return -1;
+            return AVERROR_BUFFER_TOO_SMALL;
         bytestream_put_buffer(bytestream, ptr, size);
         ptr += size;
         len -= size;
@@ -459,12 +481,41 @@ static av_cold int gif_encode_init(AVCodecContext *avctx)
 
     s->transparent_index = -1;
 
-    s->lzw = av_mallocz(ff_lzw_encode_state_size);
-    s->buf_size = avctx->width*avctx->height*2 + 1000;
-    s->buf = av_malloc(s->buf_size);
-    s->tmpl = av_malloc(avctx->width);
-    if (!s->tmpl || !s->buf || !s->lzw)
+    /* LZW coding is serial within a frame, so with slice threading several
+     * frames are encoded at once instead, at the cost of some delay. */
+    s->nb_td    = avctx->active_thread_type & FF_THREAD_SLICE ? avctx->thread_count : 1;
+    s->max_jobs = s->nb_td;
+    s->nb_slots = s->max_jobs + 1;
+
+    s->buf_size    = avctx->width*avctx->height*2 + 1000;
+    s->outbuf_size = avctx->width*avctx->height*7/5 + AV_INPUT_BUFFER_MIN_SIZE;
+    s->td = av_mallocz_array(s->nb_td, sizeof(*s->td));
+    if (!s->td)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < s->nb_td; i++) {
+        GIFThreadData *td = &s->td[i];
+
+        td->lzw  = av_mallocz(ff_lzw_encode_state_size);
+        td->buf  = av_malloc(s->buf_size);
+        td->tmpl = av_malloc(avctx->width);
+        if (!td->tmpl || !td->buf || !td->lzw)
+            return AVERROR(ENOMEM);
+    }
+
+    s->jobs = av_mallocz_array(s->nb_slots, sizeof(*s->jobs));
+    s->job_ret = av_malloc_array(s->max_jobs, sizeof(*s->job_ret));
+    s->last_frame = av_frame_alloc();
+    if (!s->jobs || !s->job_ret || !s->last_frame)
         return AVERROR(ENOMEM);
+    for (int i = 0; i < s->nb_slots; i++) {
+        GIFJob *job = &s->jobs[i];
+
+        job->frame      = av_frame_alloc();
+        job->last_frame = av_frame_alloc();
+        job->outbuf     = av_malloc(s->outbuf_size);
+        if (!job->frame || !job->last_frame || !job->outbuf)
+            return AVERROR(ENOMEM);
+    }
 
     if (avpriv_set_systematic_pal2(s->palette, avctx->pix_fmt) < 0)
         av_assert0(avctx->pix_fmt == AV_PIX_FMT_PAL8);
@@ -472,51 +523,99 @@ static av_cold int gif_encode_init(AVCodecContext *avctx)
     return 0;
 }
 
+static int gif_encode_job(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    GIFContext *s = avctx->priv_data;
+    GIFJob *job = &s->jobs[(s->first_job + jobnr) % s->nb_slots];
+    const AVFrame *pict = job->frame;
+    uint8_t *outbuf_ptr = job->outbuf;
+    int ret;
+
+    ret = gif_image_write_image(avctx, &s->td[threadnr], &outbuf_ptr,
+                                job->outbuf + s->outbuf_size,
+                                job->last_frame->buf[0] ? job->last_frame : NULL,
+                                job->frame_number, job->palette,
+                                pict->data[0], pict->linesize[0]);
+    job->size = outbuf_ptr - job->outbuf;
+    av_frame_unref(job->last_frame);
+
+    return ret;
+}
+
 static int gif_encode_frame(AVCodecContext *avctx, AVPacket *pkt,
                             const AVFrame *pict, int *got_packet)
 {
     GIFContext *s = avctx->priv_data;
-    uint8_t *outbuf_ptr, *end;
-    const uint32_t *palette = NULL;
     int ret;
 
-    if ((ret = ff_alloc_packet2(avctx, pkt, avctx->width*avctx->height*7/5 + AV_INPUT_BUFFER_MIN_SIZE, 0)) < 0)
-        return ret;
-    outbuf_ptr = pkt->data;
-    end        = pkt->data + pkt->size;
+    if (pict) {
+        GIFJob *job = &s->jobs[(s->first_job + s->nb_done + s->nb_queued) % s->nb_slots];
+        const uint32_t *palette = NULL;
 
-    if (avctx->pix_fmt == AV_PIX_FMT_PAL8) {
-        palette = (uint32_t*)pict->data[1];
+        if (avctx->pix_fmt == AV_PIX_FMT_PAL8) {
+            palette = (uint32_t*)pict->data[1];
 
-        if (!s->palette_loaded) {
-            memcpy(s->palette, palette, AVPALETTE_SIZE);
-            s->transparent_index = get_palette_transparency_index(palette);
-            s->palette_loaded = 1;
-        } else if (!memcmp(s->palette, palette, AVPALETTE_SIZE)) {
-            palette = NULL;
+            if (!s->palette_loaded) {
+                memcpy(s->palette, palette, AVPALETTE_SIZE);
+                s->transparent_index = get_palette_transparency_index(palette);
+                s->palette_loaded = 1;
+            } else if (!memcmp(s->palette, palette, AVPALETTE_SIZE)) {
+                palette = NULL;
+            }
+        }
+
+        if ((ret = av_frame_ref(job->frame, pict)) < 0)
+            return ret;
+        job->palette      = palette ? (uint32_t*)job->frame->data[1] : NULL;
+        job->frame_number = avctx->frame_number;
+
+        if (!s->image) {
+            if (s->last_frame->buf[0] &&
+                (ret = av_frame_ref(job->last_frame, s->last_frame)) < 0)
+                return ret;
+            av_frame_unref(s->last_frame);
+            if ((ret = av_frame_ref(s->last_frame, pict)) < 0)
+                return ret;
         }
+        s->nb_queued++;
     }
 
-    gif_image_write_image(avctx, &outbuf_ptr, end, palette,
-                          pict->data[0], pict->linesize[0], pkt);
-    if (!s->last_frame && !s->image) {
-        s->last_frame = av_frame_alloc();
-        if (!s->last_frame)
-            return AVERROR(ENOMEM);
+    if (!s->nb_done && (s->nb_queued == s->max_jobs || (!pict && s->nb_queued))) {
+        int nb_jobs = s->nb_queued;
+
+        avctx->execute2(avctx, gif_encode_job, NULL, s->job_ret, nb_jobs);
+        s->nb_queued = 0;
+        for (int i = 0; i < nb_jobs; i++) {
+            if (s->job_ret[i] < 0) {
+                /* drop the whole batch, the packets have to stay in order */
+                for (int j = 0; j < nb_jobs; j++)
+                    av_frame_unref(s->jobs[(s->first_job + j) % s->nb_slots].frame);
+                s->first_job = (s->first_job + nb_jobs) % s->nb_slots;
+                return s->job_ret[i];
+            }
+        }
+        s->nb_done = nb_jobs;
     }
 
-    if (!s->image) {
-        av_frame_unref(s->last_frame);
-        ret = av_frame_ref(s->last_frame, (AVFrame*)pict);
+    if (s->nb_done) {
+        GIFJob *job = &s->jobs[s->first_job];
+
+        s->first_job = (s->first_job + 1) % s->nb_slots;
+        s->nb_done--;
+
+        ret = ff_alloc_packet2(avctx, pkt, job->size, job->size);
+        if (ret >= 0) {
+            memcpy(pkt->data, job->outbuf, job->size);
+            pkt->pts = pkt->dts = job->frame->pts;
+            if (s->image || !job->frame_number)
+                pkt->flags |= AV_PKT_FLAG_KEY;
+            *got_packet = 1;
+        }
+        av_frame_unref(job->frame);
         if (ret < 0)
             return ret;
     }
 
-    pkt->size   = outbuf_ptr - pkt->data;
-    if (s->image || !avctx->frame_number)
-        pkt->flags |= AV_PKT_FLAG_KEY;
-    *got_packet = 1;
-
     return 0;
 }
 
@@ -524,12 +623,22 @@ static int gif_encode_close(AVCodecContext *avctx)
 {
     GIFContext *s = avctx->priv_data;
 
-    av_freep(&s->lzw);
-    av_freep(&s->buf);
-    av_freep(&s->shrunk_buf);
+    for (int i = 0; s->td && i < s->nb_td; i++) {
+        av_freep(&s->td[i].lzw);
+        av_freep(&s->td[i].buf);
+        av_freep(&s->td[i].shrunk_buf);
+        av_freep(&s->td[i].tmpl);
+    }
+    av_freep(&s->td);
+    for (int i = 0; s->jobs && i < s->nb_slots; i++) {
+        av_frame_free(&s->jobs[i].frame);
+        av_frame_free(&s->jobs[i].last_frame);
+        av_freep(&s->jobs[i].outbuf);
+    }
+    av_freep(&s->jobs);
+    av_freep(&s->job_ret);
     s->buf_size = 0;
     av_frame_free(&s->last_frame);
-    av_freep(&s->tmpl);
     return 0;
 }
 
@@ -560,6 +669,7 @@ AVCodec ff_gif_encoder = {
     .init           = gif_encode_init,
     .encode2        = gif_encode_frame,
     .close          = gif_encode_close,
+    .capabilities   = AV_CODEC_CAP_DELAY | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]){
         AV_PIX_FMT_RGB8, AV_PIX_FMT_BGR8, AV_PIX_FMT_RGB4_BYTE, AV_PIX_FMT_BGR4_BYTE,
         AV_PIX_FMT_GRAY8, AV_PIX_FMT_PAL8, AV_PIX_FMT_NONE
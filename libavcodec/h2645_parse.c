@@ -30,6 +30,7 @@
 #include "hevc.h"
 #include "h264.h"
 #include "h2645_parse.h"
+#include "internal.h"
 
 int ff_h2645_extract_rbsp(const uint8_t *src, int length,
                           H2645RBSP *rbsp, H2645NAL *nal, int small_padding)
@@ -98,6 +99,31 @@ int ff_h2645_extract_rbsp(const uint8_t *src, int length,
     memcpy(dst, src, i);
     si = di = i;
     while (si + 2 < length) {
+#if HAVE_FAST_UNALIGNED
+        /* a run without any zero byte cannot start an escape or a
+         * start code, so copy it a word at a time */
+#if HAVE_FAST_64BIT
+        if (si + 8 <= length &&
+            !((~AV_RN64(src + si) &
+               (AV_RN64(src + si) - 0x0101010101010101ULL)) &
+              0x8080808080808080ULL)) {
+            AV_COPY64U(dst + di, src + si);
+            si += 8;
+            di += 8;
+            continue;
+        }
+#else
+        if (si + 4 <= length &&
+            !((~AV_RN32(src + si) &
+               (AV_RN32(src + si) - 0x01010101U)) &
+              0x80808080U)) {
+            AV_COPY32U(dst + di, src + si);
+            si += 4;
+            di += 4;
+            continue;
+        }
+#endif /* HAVE_FAST_64BIT */
+#endif /* HAVE_FAST_UNALIGNED */
         // remove escapes (very rare 1:2^22)
         if (src[si + 2] > 3) {
             dst[di++] = src[si++];
@@ -520,6 +546,67 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
     return 0;
 }
 
+int ff_h2645_find_raw_nal(const uint8_t *buf, int length, int is_nalff,
+                          int nal_length_size, int *pos,
+                          const uint8_t **nal, int *nal_size)
+{
+    while (*pos < length) {
+        if (is_nalff) {
+            int i, size = 0;
+
+            if (length - *pos < nal_length_size)
+                return 0;
+            for (i = 0; i < nal_length_size; i++)
+                size = (size << 8) | buf[*pos + i];
+            *pos += nal_length_size;
+            if (size <= 0)
+                continue;
+            size = FFMIN(size, length - *pos);
+
+            *nal      = buf + *pos;
+            *nal_size = size;
+            *pos     += size;
+            return 1;
+        } else {
+            const uint8_t *start, *end = buf + length;
+            uint32_t state = -1;
+
+            start = avpriv_find_start_code(buf + *pos, end, &state);
+            if ((state & 0xFFFFFF00) != 0x100)
+                return 0;
+            start--;
+
+            state = -1;
+            *pos  = avpriv_find_start_code(start + 1, end, &state) - buf;
+            if ((state & 0xFFFFFF00) == 0x100)
+                *pos -= 4;
+
+            *nal      = start;
+            *nal_size = buf + *pos - start;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int ff_h2645_get_raw_byte(const uint8_t *buf, int size, int *pos, int *zeros)
+{
+    int b;
+
+    if (*pos >= size)
+        return -1;
+    b = buf[(*pos)++];
+    if (*zeros >= 2 && b == 3) {
+        // the byte after an escape starts a new run of zeros
+        *zeros = 0;
+        if (*pos >= size)
+            return -1;
+        b = buf[(*pos)++];
+    }
+    *zeros = b ? 0 : *zeros + 1;
+    return b;
+}
+
 void ff_h2645_packet_uninit(H2645Packet *pkt)
 {
     int i;
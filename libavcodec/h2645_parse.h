@@ -110,6 +110,32 @@ int ff_h2645_packet_split(H2645Packet *pkt, const uint8_t *buf, int length,
                           void *logctx, int is_nalff, int nal_length_size,
                           enum AVCodecID codec_id, int small_padding, int use_ref);
 
+/**
+ * Find the next NAL unit of an input packet without extracting it.
+ *
+ * This is meant for quick decisions based on NAL unit headers; the
+ * returned unit still contains any emulation_prevention_three_bytes.
+ *
+ * @param pos      offset in buf to search from, 0 on the first call;
+ *                 updated to point past the returned NAL unit
+ * @param nal      set to the first byte of the NAL unit header
+ * @param nal_size set to the size of the NAL unit
+ * @return 1 if a NAL unit was found, 0 at the end of the packet
+ */
+int ff_h2645_find_raw_nal(const uint8_t *buf, int length, int is_nalff,
+                          int nal_length_size, int *pos,
+                          const uint8_t **nal, int *nal_size);
+
+/**
+ * Read the next byte of a NAL unit returned by ff_h2645_find_raw_nal(),
+ * skipping emulation_prevention_three_bytes.
+ *
+ * @param pos   offset in buf of the next byte to read, updated
+ * @param zeros number of zero bytes just read, 0 at the start of the unit
+ * @return the unescaped byte, or a negative value at the end of buf
+ */
+int ff_h2645_get_raw_byte(const uint8_t *buf, int size, int *pos, int *zeros);
+
 /**
  * Free all the allocated memory in the packet.
  */
@@ -784,6 +784,696 @@ static av_always_inline void hl_decode_mb_idct_luma(const H264Context *h, H264Sl
     }
 }
 
+/*
+ * Reduced resolution (lowres) reconstruction.
+ *
+ * Only progressive 8-bit 4:2:0 and 4:0:0 streams are handled, the planes
+ * are 1 << lowres times smaller than the coded size. Prediction and
+ * residuals are approximated at the reduced size and the loop filter is
+ * not applied, so the output drifts from the exact decode until the next
+ * intra refresh.
+ */
+
+#define FILT3(p, k) (((p)[(k) - 1] + 2 * (p)[k] + (p)[(k) + 1] + 2) >> 2)
+#define AVG2(p, k)  (((p)[k] + (p)[(k) + 1] + 1) >> 1)
+
+static int sum_top_lowres(const uint8_t *top, int n)
+{
+    int i, sum = 0;
+    for (i = 0; i < n; i++)
+        sum += top[i];
+    return sum;
+}
+
+static int sum_left_lowres(const uint8_t *src, ptrdiff_t stride, int n)
+{
+    int i, sum = 0;
+    for (i = 0; i < n; i++)
+        sum += src[i * stride - 1];
+    return sum;
+}
+
+static void fill_lowres(uint8_t *dst, ptrdiff_t stride, int w, int h, int val)
+{
+    int y;
+    for (y = 0; y < h; y++)
+        memset(dst + y * stride, val, w);
+}
+
+/**
+ * Intra 4x4 / 8x8 prediction of a size x size block, size <= 4.
+ * The 8x8 edge filtering is not applied.
+ */
+static void pred_nxn_lowres(uint8_t *src, ptrdiff_t stride, int size,
+                            int mode, int has_topright)
+{
+    /* p[k]: left column (-k - 1) for k < 0, top-left for k == 0,
+     * top row (k - 1) for k > 0 */
+    uint8_t edge[4 + 1 + 8];
+    uint8_t *const p = edge + 4;
+    const uint8_t *top = src - stride;
+    int x, y, dc = 128;
+
+    if (mode != HOR_PRED && mode != HOR_UP_PRED &&
+        mode != LEFT_DC_PRED && mode != DC_128_PRED) {
+        memcpy(p + 1, top, size);
+        if (mode == DIAG_DOWN_LEFT_PRED || mode == VERT_LEFT_PRED) {
+            if (has_topright)
+                memcpy(p + 1 + size, top + size, size);
+            else
+                memset(p + 1 + size, top[size - 1], size);
+        }
+    }
+    if (mode == HOR_PRED || mode == DC_PRED || mode == DIAG_DOWN_RIGHT_PRED ||
+        mode == VERT_RIGHT_PRED || mode == HOR_DOWN_PRED ||
+        mode == HOR_UP_PRED || mode == LEFT_DC_PRED) {
+        for (y = 0; y < size; y++)
+            p[-1 - y] = src[y * stride - 1];
+    }
+    if (mode == DIAG_DOWN_RIGHT_PRED || mode == VERT_RIGHT_PRED ||
+        mode == HOR_DOWN_PRED)
+        p[0] = top[-1];
+
+    if (mode == DC_PRED)
+        dc = (sum_top_lowres(p + 1, size) + sum_left_lowres(src, stride, size) +
+              size) >> av_log2(2 * size);
+    else if (mode == LEFT_DC_PRED)
+        dc = (sum_left_lowres(src, stride, size) + (size >> 1)) >> av_log2(size);
+    else if (mode == TOP_DC_PRED)
+        dc = (sum_top_lowres(p + 1, size) + (size >> 1)) >> av_log2(size);
+
+    for (y = 0; y < size; y++) {
+        for (x = 0; x < size; x++) {
+            int v, z;
+
+            switch (mode) {
+            case VERT_PRED:
+                v = p[1 + x];
+                break;
+            case HOR_PRED:
+                v = p[-1 - y];
+                break;
+            case DIAG_DOWN_LEFT_PRED:
+                if (x == size - 1 && y == size - 1)
+                    v = (p[2 * size - 1] + 3 * p[2 * size] + 2) >> 2;
+                else
+                    v = FILT3(p, x + y + 2);
+                break;
+            case DIAG_DOWN_RIGHT_PRED:
+                v = FILT3(p, x - y);
+                break;
+            case VERT_RIGHT_PRED:
+                z = 2 * x - y;
+                if (z >= 0 && !(z & 1))
+                    v = AVG2(p, x - (y >> 1));
+                else if (z >= -1)
+                    v = FILT3(p, x - (y >> 1));
+                else
+                    v = FILT3(p, z + 1);
+                break;
+            case HOR_DOWN_PRED:
+                z = 2 * y - x;
+                if (z >= 0 && !(z & 1))
+                    v = AVG2(p, (x >> 1) - y - 1);
+                else if (z >= -1)
+                    v = FILT3(p, (x >> 1) - y);
+                else
+                    v = FILT3(p, x - 2 * y - 1);
+                break;
+            case VERT_LEFT_PRED:
+                if (y & 1)
+                    v = FILT3(p, x + (y >> 1) + 2);
+                else
+                    v = AVG2(p, x + (y >> 1) + 1);
+                break;
+            case HOR_UP_PRED:
+                z = x + 2 * y;
+                if (z > 2 * size - 3)
+                    v = p[-size];
+                else if (z == 2 * size - 3)
+                    v = (p[1 - size] + 3 * p[-size] + 2) >> 2;
+                else if (z & 1)
+                    v = FILT3(p, -(y + (x >> 1)) - 2);
+                else
+                    v = AVG2(p, -(y + (x >> 1)) - 2);
+                break;
+            default:
+                v = dc;
+                break;
+            }
+            src[x + y * stride] = v;
+        }
+    }
+}
+
+/**
+ * Intra 16x16 luma or 8x8 chroma prediction of a size x size block.
+ */
+static void pred_block_lowres(uint8_t *src, ptrdiff_t stride, int size,
+                              int mode, int chroma)
+{
+    const uint8_t *top = src - stride;
+    const int half     = size >> 1;
+    int x, y;
+
+    switch (mode) {
+    case VERT_PRED8x8:
+        for (y = 0; y < size; y++)
+            memcpy(src + y * stride, top, size);
+        break;
+    case HOR_PRED8x8:
+        for (y = 0; y < size; y++)
+            memset(src + y * stride, src[y * stride - 1], size);
+        break;
+    case PLANE_PRED8x8: {
+        /* least squares slope of the edges, rescaled to the block size */
+        const int d = half * (half + 1) * (2 * half + 1);
+        int H = 0, V = 0, a, b, c;
+
+        for (x = 1; x <= half; x++) {
+            H += x * (top[half - 1 + x] - top[half - 1 - x]);
+            V += x * (src[(half - 1 + x) * stride - 1] -
+                      src[(half - 1 - x) * stride - 1]);
+        }
+        b = ROUNDED_DIV(96 * H, d);
+        c = ROUNDED_DIV(96 * V, d);
+        a = 16 * (src[(size - 1) * stride - 1] + top[size - 1]) + 16 -
+            (half - 1) * (b + c);
+        for (y = 0; y < size; y++)
+            for (x = 0; x < size; x++)
+                src[x + y * stride] = av_clip_uint8((a + b * x + c * y) >> 5);
+        break;
+    }
+    case DC_PRED8x8:
+    case LEFT_DC_PRED8x8:
+    case TOP_DC_PRED8x8:
+        if (chroma) {
+            /* per quadrant, like the 4x4 chroma DC blocks */
+            const int shift = av_log2(half);
+            const int t0 = sum_top_lowres(top, half);
+            const int t1 = sum_top_lowres(top + half, half);
+            const int l0 = mode != TOP_DC_PRED8x8 ? sum_left_lowres(src, stride, half) : 0;
+            const int l1 = mode != TOP_DC_PRED8x8 ? sum_left_lowres(src + half * stride, stride, half) : 0;
+            int dc[4];
+
+            if (mode == DC_PRED8x8) {
+                dc[0] = (t0 + l0 + half) >> (shift + 1);
+                dc[1] = (t1 + (half >> 1)) >> shift;
+                dc[2] = (l1 + (half >> 1)) >> shift;
+                dc[3] = (t1 + l1 + half) >> (shift + 1);
+            } else if (mode == LEFT_DC_PRED8x8) {
+                dc[0] = dc[1] = (l0 + (half >> 1)) >> shift;
+                dc[2] = dc[3] = (l1 + (half >> 1)) >> shift;
+            } else {
+                dc[0] = dc[2] = (t0 + (half >> 1)) >> shift;
+                dc[1] = dc[3] = (t1 + (half >> 1)) >> shift;
+            }
+            for (y = 0; y < 4; y++)
+                fill_lowres(src + (y & 1) * half + (y >> 1) * half * stride,
+                            stride, half, half, dc[y]);
+        } else {
+            const int shift = av_log2(size);
+            int dc;
+
+            if (mode == DC_PRED8x8)
+                dc = (sum_top_lowres(top, size) +
+                      sum_left_lowres(src, stride, size) + size) >> (shift + 1);
+            else if (mode == LEFT_DC_PRED8x8)
+                dc = (sum_left_lowres(src, stride, size) + half) >> shift;
+            else
+                dc = (sum_top_lowres(top, size) + half) >> shift;
+            fill_lowres(src, stride, size, size, dc);
+        }
+        break;
+    default:
+        fill_lowres(src, stride, size, size, 128);
+        break;
+    }
+}
+
+static void idct4_1d_lowres(int *d, int s)
+{
+    const int z0 =  d[0 * s]       +  d[2 * s];
+    const int z1 =  d[0 * s]       -  d[2 * s];
+    const int z2 = (d[1 * s] >> 1) -  d[3 * s];
+    const int z3 =  d[1 * s]       + (d[3 * s] >> 1);
+
+    d[0 * s] = z0 + z3;
+    d[1 * s] = z1 + z2;
+    d[2 * s] = z1 - z2;
+    d[3 * s] = z0 - z3;
+}
+
+static void idct8_1d_lowres(int *d, int s)
+{
+    const int a0 =  d[0 * s]       +  d[4 * s];
+    const int a2 =  d[0 * s]       -  d[4 * s];
+    const int a4 = (d[2 * s] >> 1) -  d[6 * s];
+    const int a6 = (d[6 * s] >> 1) +  d[2 * s];
+
+    const int b0 = a0 + a6;
+    const int b2 = a2 + a4;
+    const int b4 = a2 - a4;
+    const int b6 = a0 - a6;
+
+    const int a1 = -d[3 * s] + d[5 * s] - d[7 * s] - (d[7 * s] >> 1);
+    const int a3 =  d[1 * s] + d[7 * s] - d[3 * s] - (d[3 * s] >> 1);
+    const int a5 = -d[1 * s] + d[7 * s] + d[5 * s] + (d[5 * s] >> 1);
+    const int a7 =  d[3 * s] + d[5 * s] + d[1 * s] + (d[1 * s] >> 1);
+
+    const int b1 = (a7 >> 2) + a1;
+    const int b3 =  a3 + (a5 >> 2);
+    const int b5 = (a3 >> 2) - a5;
+    const int b7 =  a7 - (a1 >> 2);
+
+    d[0 * s] = b0 + b7;
+    d[7 * s] = b0 - b7;
+    d[1 * s] = b2 + b5;
+    d[6 * s] = b2 - b5;
+    d[2 * s] = b4 + b3;
+    d[5 * s] = b4 - b3;
+    d[3 * s] = b6 + b1;
+    d[4 * s] = b6 - b1;
+}
+
+/**
+ * Inverse transform an n x n block at full size, add the box-downscaled
+ * residual to dst and clear the coefficients.
+ */
+static void idct_add_lowres(uint8_t *dst, ptrdiff_t stride, int16_t *block,
+                            int n, int lowres)
+{
+    const int size  = n >> lowres;
+    const int shift = 6 + 2 * lowres;
+    int res[64];
+    int i, x, y, j, k;
+
+    for (i = 0; i < n * n; i++)
+        res[i] = block[i];
+    res[0] += 32;
+
+    for (i = 0; i < n; i++) {
+        if (n == 8)
+            idct8_1d_lowres(res + i, 8);
+        else
+            idct4_1d_lowres(res + i, 4);
+    }
+    /* the second pass leaves output row y, column x at res[y + n * x] */
+    for (i = 0; i < n; i++) {
+        if (n == 8)
+            idct8_1d_lowres(res + 8 * i, 1);
+        else
+            idct4_1d_lowres(res + 4 * i, 1);
+    }
+
+    for (y = 0; y < size; y++)
+        for (x = 0; x < size; x++) {
+            int sum = 0;
+            for (j = 0; j < 1 << lowres; j++)
+                for (k = 0; k < 1 << lowres; k++)
+                    sum += res[(y << lowres) + j + n * ((x << lowres) + k)];
+            dst[x + y * stride] = av_clip_uint8(dst[x + y * stride] + (sum >> shift));
+        }
+
+    memset(block, 0, n * n * sizeof(*block));
+}
+
+static void put_pixels_lowres(uint8_t *dst, ptrdiff_t stride,
+                              const uint8_t *src, int src_stride,
+                              int size, int lowres)
+{
+    const int round = 1 << (2 * lowres - 1);
+    int x, y, j, k;
+
+    for (y = 0; y < size; y++)
+        for (x = 0; x < size; x++) {
+            const uint8_t *s = src + ((x + y * src_stride) << lowres);
+            int sum = 0;
+            for (j = 0; j < 1 << lowres; j++)
+                for (k = 0; k < 1 << lowres; k++)
+                    sum += s[k + j * src_stride];
+            dst[x + y * stride] = (sum + round) >> (2 * lowres);
+        }
+}
+
+static void weight_lowres(uint8_t *block, ptrdiff_t stride, int w, int height,
+                          int log2_denom, int weight, int offset)
+{
+    int x, y;
+
+    offset = (unsigned)offset << log2_denom;
+    if (log2_denom)
+        offset += 1 << (log2_denom - 1);
+    for (y = 0; y < height; y++, block += stride)
+        for (x = 0; x < w; x++)
+            block[x] = av_clip_uint8((block[x] * weight + offset) >> log2_denom);
+}
+
+static void biweight_lowres(uint8_t *dst, const uint8_t *src, ptrdiff_t stride,
+                            int w, int height, int log2_denom,
+                            int weightd, int weights, int offset)
+{
+    int x, y;
+
+    offset = (unsigned)((offset + 1) | 1) << log2_denom;
+    for (y = 0; y < height; y++, dst += stride, src += stride)
+        for (x = 0; x < w; x++)
+            dst[x] = av_clip_uint8((src[x] * weights + dst[x] * weightd +
+                                    offset) >> (log2_denom + 1));
+}
+
+/**
+ * Bilinear motion compensation of a w x height (full size) partition at
+ * (x, y), with 1/8 sample precision at the reduced size.
+ */
+static void mc_dir_part_lowres(const H264Context *h, H264SliceContext *sl,
+                               H264Ref *pic, int n, int w, int height,
+                               int list, uint8_t *dest_y, uint8_t *dest_cb,
+                               uint8_t *dest_cr, int x, int y,
+                               const h264_chroma_mc_func *pix_op)
+{
+    const int lowres     = h->avctx->lowres;
+    const int lw         = w      >> lowres;
+    const int lh         = height >> lowres;
+    const int pic_width  = 16 * h->mb_width  >> lowres;
+    const int pic_height = 16 * h->mb_height >> lowres;
+    const int mx = 4 * x + sl->mv_cache[list][scan8[n]][0];
+    const int my = 4 * y + sl->mv_cache[list][scan8[n]][1];
+    int lx = mx * 2 >> lowres;
+    int ly = my * 2 >> lowres;
+    uint8_t *src = pic->data[0] + (lx >> 3) + (ly >> 3) * sl->mb_linesize;
+    uint8_t *src_cb, *src_cr;
+
+    if ((lx >> 3) < 0 || (lx >> 3) + lw + 1 > pic_width ||
+        (ly >> 3) < 0 || (ly >> 3) + lh + 1 > pic_height) {
+        h->vdsp.emulated_edge_mc(sl->edge_emu_buffer, src,
+                                 sl->mb_linesize, sl->mb_linesize,
+                                 lw + 1, lh + 1, lx >> 3, ly >> 3,
+                                 pic_width, pic_height);
+        src = sl->edge_emu_buffer;
+    }
+    pix_op[3 - av_log2(lw)](dest_y, src, sl->mb_linesize, lh, lx & 7, ly & 7);
+
+    if (CONFIG_GRAY && h->flags & AV_CODEC_FLAG_GRAY)
+        return;
+
+    /* the chroma vectors are in 1/8 sample units at full size */
+    lx = mx >> lowres;
+    ly = my >> lowres;
+    src_cb = pic->data[1] + (lx >> 3) + (ly >> 3) * sl->mb_uvlinesize;
+    src_cr = pic->data[2] + (lx >> 3) + (ly >> 3) * sl->mb_uvlinesize;
+
+    if ((lx >> 3) < 0 || (lx >> 3) + (lw >> 1) + 1 > pic_width  >> 1 ||
+        (ly >> 3) < 0 || (ly >> 3) + (lh >> 1) + 1 > pic_height >> 1) {
+        h->vdsp.emulated_edge_mc(sl->edge_emu_buffer, src_cb,
+                                 sl->mb_uvlinesize, sl->mb_uvlinesize,
+                                 (lw >> 1) + 1, (lh >> 1) + 1, lx >> 3, ly >> 3,
+                                 pic_width >> 1, pic_height >> 1);
+        src_cb = sl->edge_emu_buffer;
+        pix_op[4 - av_log2(lw)](dest_cb, src_cb, sl->mb_uvlinesize, lh >> 1,
+                                lx & 7, ly & 7);
+        h->vdsp.emulated_edge_mc(sl->edge_emu_buffer, src_cr,
+                                 sl->mb_uvlinesize, sl->mb_uvlinesize,
+                                 (lw >> 1) + 1, (lh >> 1) + 1, lx >> 3, ly >> 3,
+                                 pic_width >> 1, pic_height >> 1);
+        src_cr = sl->edge_emu_buffer;
+    } else {
+        pix_op[4 - av_log2(lw)](dest_cb, src_cb, sl->mb_uvlinesize, lh >> 1,
+                                lx & 7, ly & 7);
+    }
+    pix_op[4 - av_log2(lw)](dest_cr, src_cr, sl->mb_uvlinesize, lh >> 1,
+                            lx & 7, ly & 7);
+}
+
+static void mc_part_lowres(const H264Context *h, H264SliceContext *sl,
+                           int n, int w, int height, int x_offset, int y_offset,
+                           uint8_t *dest_y, uint8_t *dest_cb, uint8_t *dest_cr,
+                           int list0, int list1)
+{
+    const int lowres = h->avctx->lowres;
+    const int lw     = w      >> lowres;
+    const int lh     = height >> lowres;
+    const int x      = 16 * sl->mb_x + x_offset;
+    const int y      = 16 * sl->mb_y + y_offset;
+    const int refn0  = sl->ref_cache[0][scan8[n]];
+    const int refn1  = sl->ref_cache[1][scan8[n]];
+
+    dest_y  += (x_offset >> lowres)     + (y_offset >> lowres)     * sl->mb_linesize;
+    dest_cb += (x_offset >> lowres + 1) + (y_offset >> lowres + 1) * sl->mb_uvlinesize;
+    dest_cr += (x_offset >> lowres + 1) + (y_offset >> lowres + 1) * sl->mb_uvlinesize;
+
+    if ((sl->pwt.use_weight == 2 && list0 && list1 &&
+         sl->pwt.implicit_weight[refn0][refn1][sl->mb_y & 1] != 32) ||
+        sl->pwt.use_weight == 1) {
+        const int chroma = !CONFIG_GRAY || !(h->flags & AV_CODEC_FLAG_GRAY);
+
+        if (list0 && list1) {
+            uint8_t *tmp_cb = sl->bipred_scratchpad;
+            uint8_t *tmp_cr = sl->bipred_scratchpad + 16;
+            uint8_t *tmp_y  = sl->bipred_scratchpad + 16 * sl->mb_uvlinesize;
+
+            mc_dir_part_lowres(h, sl, &sl->ref_list[0][refn0], n, w, height, 0,
+                               dest_y, dest_cb, dest_cr, x, y,
+                               h->h264chroma.put_h264_chroma_pixels_tab);
+            mc_dir_part_lowres(h, sl, &sl->ref_list[1][refn1], n, w, height, 1,
+                               tmp_y, tmp_cb, tmp_cr, x, y,
+                               h->h264chroma.put_h264_chroma_pixels_tab);
+
+            if (sl->pwt.use_weight == 2) {
+                int weight0 = sl->pwt.implicit_weight[refn0][refn1][sl->mb_y & 1];
+                int weight1 = 64 - weight0;
+                biweight_lowres(dest_y, tmp_y, sl->mb_linesize, lw, lh,
+                                5, weight0, weight1, 0);
+                if (chroma) {
+                    biweight_lowres(dest_cb, tmp_cb, sl->mb_uvlinesize,
+                                    lw >> 1, lh >> 1, 5, weight0, weight1, 0);
+                    biweight_lowres(dest_cr, tmp_cr, sl->mb_uvlinesize,
+                                    lw >> 1, lh >> 1, 5, weight0, weight1, 0);
+                }
+            } else {
+                biweight_lowres(dest_y, tmp_y, sl->mb_linesize, lw, lh,
+                                sl->pwt.luma_log2_weight_denom,
+                                sl->pwt.luma_weight[refn0][0][0],
+                                sl->pwt.luma_weight[refn1][1][0],
+                                sl->pwt.luma_weight[refn0][0][1] +
+                                sl->pwt.luma_weight[refn1][1][1]);
+                if (chroma) {
+                    biweight_lowres(dest_cb, tmp_cb, sl->mb_uvlinesize,
+                                    lw >> 1, lh >> 1,
+                                    sl->pwt.chroma_log2_weight_denom,
+                                    sl->pwt.chroma_weight[refn0][0][0][0],
+                                    sl->pwt.chroma_weight[refn1][1][0][0],
+                                    sl->pwt.chroma_weight[refn0][0][0][1] +
+                                    sl->pwt.chroma_weight[refn1][1][0][1]);
+                    biweight_lowres(dest_cr, tmp_cr, sl->mb_uvlinesize,
+                                    lw >> 1, lh >> 1,
+                                    sl->pwt.chroma_log2_weight_denom,
+                                    sl->pwt.chroma_weight[refn0][0][1][0],
+                                    sl->pwt.chroma_weight[refn1][1][1][0],
+                                    sl->pwt.chroma_weight[refn0][0][1][1] +
+                                    sl->pwt.chroma_weight[refn1][1][1][1]);
+                }
+            }
+        } else {
+            const int list = list1 ? 1 : 0;
+            const int refn = list1 ? refn1 : refn0;
+
+            mc_dir_part_lowres(h, sl, &sl->ref_list[list][refn], n, w, height,
+                               list, dest_y, dest_cb, dest_cr, x, y,
+                               h->h264chroma.put_h264_chroma_pixels_tab);
+            weight_lowres(dest_y, sl->mb_linesize, lw, lh,
+                          sl->pwt.luma_log2_weight_denom,
+                          sl->pwt.luma_weight[refn][list][0],
+                          sl->pwt.luma_weight[refn][list][1]);
+            if (chroma && sl->pwt.use_weight_chroma) {
+                weight_lowres(dest_cb, sl->mb_uvlinesize, lw >> 1, lh >> 1,
+                              sl->pwt.chroma_log2_weight_denom,
+                              sl->pwt.chroma_weight[refn][list][0][0],
+                              sl->pwt.chroma_weight[refn][list][0][1]);
+                weight_lowres(dest_cr, sl->mb_uvlinesize, lw >> 1, lh >> 1,
+                              sl->pwt.chroma_log2_weight_denom,
+                              sl->pwt.chroma_weight[refn][list][1][0],
+                              sl->pwt.chroma_weight[refn][list][1][1]);
+            }
+        }
+    } else {
+        const h264_chroma_mc_func *pix_op = h->h264chroma.put_h264_chroma_pixels_tab;
+
+        if (list0) {
+            mc_dir_part_lowres(h, sl, &sl->ref_list[0][refn0], n, w, height, 0,
+                               dest_y, dest_cb, dest_cr, x, y, pix_op);
+            pix_op = h->h264chroma.avg_h264_chroma_pixels_tab;
+        }
+        if (list1)
+            mc_dir_part_lowres(h, sl, &sl->ref_list[1][refn1], n, w, height, 1,
+                               dest_y, dest_cb, dest_cr, x, y, pix_op);
+    }
+}
+
+static void hl_motion_lowres(const H264Context *h, H264SliceContext *sl,
+                             uint8_t *dest_y, uint8_t *dest_cb, uint8_t *dest_cr)
+{
+    const int mb_type = h->cur_pic.mb_type[sl->mb_xy];
+    int i, j;
+
+    if (HAVE_THREADS && (h->avctx->active_thread_type & FF_THREAD_FRAME))
+        await_references(h, sl);
+
+    if (IS_16X16(mb_type)) {
+        mc_part_lowres(h, sl, 0, 16, 16, 0, 0, dest_y, dest_cb, dest_cr,
+                       IS_DIR(mb_type, 0, 0), IS_DIR(mb_type, 0, 1));
+    } else if (IS_16X8(mb_type)) {
+        mc_part_lowres(h, sl, 0, 16, 8, 0, 0, dest_y, dest_cb, dest_cr,
+                       IS_DIR(mb_type, 0, 0), IS_DIR(mb_type, 0, 1));
+        mc_part_lowres(h, sl, 8, 16, 8, 0, 8, dest_y, dest_cb, dest_cr,
+                       IS_DIR(mb_type, 1, 0), IS_DIR(mb_type, 1, 1));
+    } else if (IS_8X16(mb_type)) {
+        mc_part_lowres(h, sl, 0, 8, 16, 0, 0, dest_y, dest_cb, dest_cr,
+                       IS_DIR(mb_type, 0, 0), IS_DIR(mb_type, 0, 1));
+        mc_part_lowres(h, sl, 4, 8, 16, 8, 0, dest_y, dest_cb, dest_cr,
+                       IS_DIR(mb_type, 1, 0), IS_DIR(mb_type, 1, 1));
+    } else {
+        av_assert2(IS_8X8(mb_type));
+
+        for (i = 0; i < 4; i++) {
+            const int sub_mb_type = sl->sub_mb_type[i];
+            const int n     = 4 * i;
+            const int x     = (i & 1) << 3;
+            const int y     = (i & 2) << 2;
+            const int list0 = IS_DIR(sub_mb_type, 0, 0);
+            const int list1 = IS_DIR(sub_mb_type, 0, 1);
+
+            /* at quarter size the sub-partitions are a single chroma
+             * sample, predict them with the first motion vector */
+            if (IS_SUB_8X8(sub_mb_type) || h->avctx->lowres > 1) {
+                mc_part_lowres(h, sl, n, 8, 8, x, y,
+                               dest_y, dest_cb, dest_cr, list0, list1);
+            } else if (IS_SUB_8X4(sub_mb_type)) {
+                mc_part_lowres(h, sl, n,     8, 4, x, y,
+                               dest_y, dest_cb, dest_cr, list0, list1);
+                mc_part_lowres(h, sl, n + 2, 8, 4, x, y + 4,
+                               dest_y, dest_cb, dest_cr, list0, list1);
+            } else if (IS_SUB_4X8(sub_mb_type)) {
+                mc_part_lowres(h, sl, n,     4, 8, x,     y,
+                               dest_y, dest_cb, dest_cr, list0, list1);
+                mc_part_lowres(h, sl, n + 1, 4, 8, x + 4, y,
+                               dest_y, dest_cb, dest_cr, list0, list1);
+            } else {
+                av_assert2(IS_SUB_4X4(sub_mb_type));
+                for (j = 0; j < 4; j++)
+                    mc_part_lowres(h, sl, n + j, 4, 4,
+                                   x + 4 * (j & 1), y + 2 * (j & 2),
+                                   dest_y, dest_cb, dest_cr, list0, list1);
+            }
+        }
+    }
+}
+
+/**
+ * Offset of the 4x4 block n at the reduced size, relative to the first
+ * block of its plane (first = 0 for luma, 16 for Cb, 32 for Cr).
+ */
+static av_always_inline int block_offset_lowres(int n, int first,
+                                                ptrdiff_t stride, int lowres)
+{
+    const int d = scan8[n] - scan8[first];
+    return ((d & 7) * 4 >> lowres) + ((d >> 3) * 4 >> lowres) * stride;
+}
+
+static void hl_decode_mb_lowres(const H264Context *h, H264SliceContext *sl)
+{
+    const int lowres  = h->avctx->lowres;
+    const int mb_xy   = sl->mb_xy;
+    const int mb_type = h->cur_pic.mb_type[mb_xy];
+    const int size    = 16 >> lowres;
+    const int csize   =  8 >> lowres;
+    const ptrdiff_t linesize   = sl->mb_linesize   = sl->linesize;
+    const ptrdiff_t uvlinesize = sl->mb_uvlinesize = sl->uvlinesize;
+    const int chroma  = !CONFIG_GRAY || !(h->flags & AV_CODEC_FLAG_GRAY);
+    uint8_t *dest_y   = h->cur_pic.f->data[0] + (sl->mb_x + sl->mb_y * linesize)   * size;
+    uint8_t *dest_cb  = h->cur_pic.f->data[1] + (sl->mb_x + sl->mb_y * uvlinesize) * csize;
+    uint8_t *dest_cr  = h->cur_pic.f->data[2] + (sl->mb_x + sl->mb_y * uvlinesize) * csize;
+    int i;
+
+    h->list_counts[mb_xy] = sl->list_count;
+
+    if (IS_INTRA_PCM(mb_type)) {
+        put_pixels_lowres(dest_y, linesize, sl->intra_pcm_ptr, 16, size, lowres);
+        if (chroma) {
+            if (h->ps.sps->chroma_format_idc) {
+                put_pixels_lowres(dest_cb, uvlinesize, sl->intra_pcm_ptr + 256,
+                                  8, csize, lowres);
+                put_pixels_lowres(dest_cr, uvlinesize, sl->intra_pcm_ptr + 320,
+                                  8, csize, lowres);
+            } else {
+                fill_lowres(dest_cb, uvlinesize, csize, csize, 128);
+                fill_lowres(dest_cr, uvlinesize, csize, csize, 128);
+            }
+        }
+        return;
+    }
+
+    if (IS_INTRA(mb_type)) {
+        if (chroma) {
+            pred_block_lowres(dest_cb, uvlinesize, csize, sl->chroma_pred_mode, 1);
+            pred_block_lowres(dest_cr, uvlinesize, csize, sl->chroma_pred_mode, 1);
+        }
+
+        if (IS_INTRA4x4(mb_type)) {
+            const int dct8 = IS_8x8DCT(mb_type);
+            const int n    = dct8 ? 8 : 4;
+
+            for (i = 0; i < 16; i += dct8 ? 4 : 1) {
+                uint8_t *ptr = dest_y + block_offset_lowres(i, 0, linesize, lowres);
+                int topright = dct8 ? (sl->topright_samples_available << i) & 0x4000
+                                    : (sl->topright_samples_available << i) & 0x8000;
+
+                pred_nxn_lowres(ptr, linesize, n >> lowres,
+                                sl->intra4x4_pred_mode_cache[scan8[i]], topright);
+                if (sl->non_zero_count_cache[scan8[i]])
+                    idct_add_lowres(ptr, linesize, sl->mb + i * 16, n, lowres);
+            }
+        } else {
+            pred_block_lowres(dest_y, linesize, size, sl->intra16x16_pred_mode, 0);
+            if (sl->non_zero_count_cache[scan8[LUMA_DC_BLOCK_INDEX]])
+                h->h264dsp.h264_luma_dc_dequant_idct(sl->mb, sl->mb_luma_dc[0],
+                                                     h->ps.pps->dequant4_coeff[0][sl->qscale][0]);
+            for (i = 0; i < 16; i++)
+                if (sl->non_zero_count_cache[scan8[i]] || sl->mb[i * 16])
+                    idct_add_lowres(dest_y + block_offset_lowres(i, 0, linesize, lowres),
+                                    linesize, sl->mb + i * 16, 4, lowres);
+        }
+    } else {
+        hl_motion_lowres(h, sl, dest_y, dest_cb, dest_cr);
+
+        if (sl->cbp & 15) {
+            const int dct8 = IS_8x8DCT(mb_type);
+
+            for (i = 0; i < 16; i += dct8 ? 4 : 1)
+                if (sl->non_zero_count_cache[scan8[i]])
+                    idct_add_lowres(dest_y + block_offset_lowres(i, 0, linesize, lowres),
+                                    linesize, sl->mb + i * 16, dct8 ? 8 : 4, lowres);
+        }
+    }
+
+    if (chroma && (sl->cbp & 0x30)) {
+        uint8_t *dest[2] = { dest_cb, dest_cr };
+        int j;
+
+        for (j = 0; j < 2; j++) {
+            const int first = 16 * (j + 1);
+
+            if (sl->non_zero_count_cache[scan8[CHROMA_DC_BLOCK_INDEX + j]])
+                h->h264dsp.h264_chroma_dc_dequant_idct(sl->mb + first * 16,
+                                                       h->ps.pps->dequant4_coeff[IS_INTRA(mb_type) ? j + 1 : j + 4][sl->chroma_qp[j]][0]);
+            for (i = first; i < first + 4; i++)
+                if (sl->non_zero_count_cache[scan8[i]] || sl->mb[i * 16])
+                    idct_add_lowres(dest[j] + block_offset_lowres(i, first, uvlinesize, lowres),
+                                    uvlinesize, sl->mb + i * 16, 4, lowres);
+        }
+    }
+}
+
 #define BITS   8
 #define SIMPLE 1
 #include "h264_mb_template.c"
@@ -803,6 +1493,11 @@ void ff_h264_hl_decode_mb(const H264Context *h, H264SliceContext *sl)
     int is_complex    = CONFIG_SMALL || sl->is_complex ||
                         IS_INTRA_PCM(mb_type) || sl->qscale == 0;
 
+    if (h->avctx->lowres) {
+        hl_decode_mb_lowres(h, sl);
+        return;
+    }
+
     if (CHROMA444(h)) {
         if (is_complex || h->pixel_shift)
             hl_decode_mb_444_complex(h, sl);
@@ -476,6 +476,9 @@ static int h264_metadata_update_fragment(AVBSFContext *bsf, AVPacket *pkt,
     has_sps = 0;
     for (i = 0; i < au->nb_units; i++) {
         if (au->units[i].type == H264_NAL_SPS) {
+            err = ff_cbs_make_unit_writable(ctx->common.input, &au->units[i]);
+            if (err < 0)
+                return err;
             err = h264_metadata_update_sps(bsf, au->units[i].content);
             if (err < 0)
                 return err;
@@ -536,6 +539,18 @@ static const CBSBSFType h264_metadata_type = {
     .fragment_name   = "access unit",
     .unit_name       = "NAL unit",
     .update_fragment = &h264_metadata_update_fragment,
+    .passthrough_unmodified = 1,
+};
+
+static const CodedBitstreamUnitType h264_metadata_decompose_sps[] = {
+    H264_NAL_SPS,
+};
+
+static const CodedBitstreamUnitType h264_metadata_decompose_slices[] = {
+    H264_NAL_SPS,
+    H264_NAL_PPS,
+    H264_NAL_SLICE,
+    H264_NAL_IDR_SLICE,
 };
 
 static int h264_metadata_init(AVBSFContext *bsf)
@@ -575,6 +590,23 @@ static int h264_metadata_init(AVBSFContext *bsf)
         }
     }
 
+    // In passthrough mode, only decompose the units which will be looked
+    // at: everything else passes through untouched.
+    if (ctx->common.passthrough && !ctx->sei_user_data &&
+        !ctx->delete_filler && ctx->display_orientation == BSF_ELEMENT_PASS) {
+        if (ctx->aud == BSF_ELEMENT_INSERT) {
+            ctx->common.decompose_unit_types =
+                h264_metadata_decompose_slices;
+            ctx->common.nb_decompose_unit_types =
+                FF_ARRAY_ELEMS(h264_metadata_decompose_slices);
+        } else {
+            ctx->common.decompose_unit_types =
+                h264_metadata_decompose_sps;
+            ctx->common.nb_decompose_unit_types =
+                FF_ARRAY_ELEMS(h264_metadata_decompose_sps);
+        }
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h264_metadata_type);
 }
 
@@ -685,6 +717,10 @@ static const AVOption h264_metadata_options[] = {
     { LEVEL("6.2", 62) },
 #undef LEVEL
 
+    { "passthrough", "Pass unmodified NAL units through without rewriting them",
+        OFFSET(common.passthrough), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -907,6 +907,17 @@ static void init_dimensions(H264Context *h)
         h->height_from_caller = 0;
     }
 
+    /* lowres pictures are allocated and cropped at the reduced size */
+    if (h->avctx->lowres) {
+        const int lowres = h->avctx->lowres;
+        width  = AV_CEIL_RSHIFT(width,  lowres);
+        height = AV_CEIL_RSHIFT(height, lowres);
+        cl   >>= lowres;
+        ct   >>= lowres;
+        cr     = (h->width  >> lowres) - width  - cl;
+        cb     = (h->height >> lowres) - height - ct;
+    }
+
     h->avctx->coded_width  = h->width;
     h->avctx->coded_height = h->height;
     h->avctx->width        = width;
@@ -1042,6 +1053,14 @@ static int h264_init_ps(H264Context *h, const H264SliceContext *sl, int first_sl
     }
     sps = h->ps.sps;
 
+    if (h->avctx->lowres &&
+        (!sps->frame_mbs_only_flag || sps->bit_depth_luma > 8 ||
+         sps->chroma_format_idc > 1 || sps->transform_bypass)) {
+        avpriv_request_sample(h->avctx, "lowres with interlaced, high bit depth, "
+                              "4:2:2, 4:4:4 or lossless coding");
+        return AVERROR_PATCHWELCOME;
+    }
+
     must_reinit = (h->context_initialized &&
                     (   16*sps->mb_width != h->avctx->coded_width
                      || 16*sps->mb_height != h->avctx->coded_height
@@ -1994,7 +2013,8 @@ static int h264_slice_init(H264Context *h, H264SliceContext *sl,
         (h->avctx->skip_loop_filter >= AVDISCARD_BIDIR  &&
          sl->slice_type_nos == AV_PICTURE_TYPE_B) ||
         (h->avctx->skip_loop_filter >= AVDISCARD_NONREF &&
-         nal->ref_idc == 0))
+         nal->ref_idc == 0) ||
+        h->avctx->lowres)
         sl->deblocking_filter = 0;
 
     if (sl->deblocking_filter == 1 && h->nb_slice_ctx > 1) {
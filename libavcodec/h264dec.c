@@ -113,6 +113,11 @@ void ff_h264_draw_horiz_band(const H264Context *h, H264SliceContext *sl,
         y      <<= 1;
     }
 
+    if (avctx->lowres) {
+        height = AV_CEIL_RSHIFT(y + height, avctx->lowres) - (y >> avctx->lowres);
+        y    >>= avctx->lowres;
+    }
+
     height = FFMIN(height, avctx->height - y);
 
     if (field_pic && h->first_field && !(avctx->slice_flags & SLICE_FLAG_ALLOW_FIELD))
@@ -411,6 +416,10 @@ static av_cold int h264_decode_init(AVCodecContext *avctx)
     if (h->enable_er < 0 && (avctx->active_thread_type & FF_THREAD_SLICE))
         h->enable_er = 0;
 
+    /* error concealment works on full size macroblocks */
+    if (avctx->lowres)
+        h->enable_er = 0;
+
     if (h->enable_er && (avctx->active_thread_type & FF_THREAD_SLICE)) {
         av_log(avctx, AV_LOG_WARNING,
                "Error resilience with slice threads is enabled. It is unsafe and unsupported and may crash. "
@@ -478,8 +487,9 @@ static void h264_decode_flush(AVCodecContext *avctx)
 
     h->mb_y = 0;
 
-    ff_h264_free_tables(h);
-    h->context_initialized = 0;
+    /* The per-macroblock tables and buffer pools only depend on the stream
+     * dimensions, which slice header parsing checks again anyway, so keep
+     * them allocated to make seeking cheap. */
 }
 
 static int get_last_needed_nal(H264Context *h)
@@ -871,6 +881,74 @@ static int is_avcc_extradata(const uint8_t *buf, int buf_size)
     return 1;
 }
 
+/**
+ * Look for a recovery point message in a still escaped SEI NAL unit.
+ * Anything which does not parse is assumed to contain one.
+ */
+static int sei_has_recovery_point(const uint8_t *buf, int size)
+{
+    int pos = 1, zeros = 0;
+
+    do {
+        int b, type = 0, len = 0;
+
+        do {
+            if ((b = ff_h2645_get_raw_byte(buf, size, &pos, &zeros)) < 0)
+                return 1;
+            type += b;
+        } while (b == 255);
+        do {
+            if ((b = ff_h2645_get_raw_byte(buf, size, &pos, &zeros)) < 0)
+                return 1;
+            len += b;
+        } while (b == 255);
+
+        if (type == SEI_TYPE_RECOVERY_POINT)
+            return 1;
+        while (len--)
+            if (ff_h2645_get_raw_byte(buf, size, &pos, &zeros) < 0)
+                return 1;
+    } while (pos < size && buf[pos] != 0x80);
+
+    return 0;
+}
+
+/**
+ * Check from the NAL unit headers alone whether a packet can be dropped
+ * when only keyframes are decoded: it has slices, but no IDR slice,
+ * recovery point or anything else the decoder has to look at.
+ */
+static int is_nonkey_packet(const H264Context *h, const uint8_t *buf, int buf_size)
+{
+    const uint8_t *nal;
+    int pos = 0, nal_size, nb_slices = 0;
+
+    while (ff_h2645_find_raw_nal(buf, buf_size, h->is_avc, h->nal_length_size,
+                                 &pos, &nal, &nal_size)) {
+        switch (nal[0] & 0x1f) {
+        case H264_NAL_SLICE:
+        case H264_NAL_DPA:
+        case H264_NAL_DPB:
+        case H264_NAL_DPC:
+        case H264_NAL_AUXILIARY_SLICE:
+            nb_slices++;
+            break;
+        case H264_NAL_SEI:
+            if (sei_has_recovery_point(nal, nal_size))
+                return 0;
+            break;
+        case H264_NAL_AUD:
+        case H264_NAL_FILLER_DATA:
+        case H264_NAL_SPS_EXT:
+            break;
+        default:
+            return 0;
+        }
+    }
+
+    return nb_slices > 0;
+}
+
 static int finalize_frame(H264Context *h, AVFrame *dst, H264Picture *out, int *got_frame)
 {
     int ret;
@@ -988,6 +1066,13 @@ static int h264_decode_frame(AVCodecContext *avctx, void *data,
                                             avctx->err_recognition, avctx);
     }
 
+    /* With skip_frame=nokey, drop whole packets without keyframes before
+     * splitting them into NAL units, unless a second field is pending. */
+    if (avctx->skip_frame >= AVDISCARD_NONKEY && !h->first_field &&
+        !(avctx->flags2 & AV_CODEC_FLAG2_CHUNKS) &&
+        is_nonkey_packet(h, buf, buf_size))
+        return buf_size;
+
     buf_index = decode_nal_units(h, buf, buf_size);
     if (buf_index < 0)
         return AVERROR_INVALIDDATA;
@@ -1083,5 +1168,6 @@ AVCodec ff_h264_decoder = {
     .flush                 = h264_decode_flush,
     .update_thread_context = ONLY_IF_THREADS_ENABLED(ff_h264_update_thread_context),
     .profiles              = NULL_IF_CONFIG_SMALL(ff_h264_profiles),
+    .max_lowres            = 2,
     .priv_class            = &h264_class,
 };
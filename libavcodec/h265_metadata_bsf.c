@@ -382,11 +382,17 @@ static int h265_metadata_update_fragment(AVBSFContext *bsf, AVPacket *pkt,
 
     for (i = 0; i < au->nb_units; i++) {
         if (au->units[i].type == HEVC_NAL_VPS) {
+            err = ff_cbs_make_unit_writable(ctx->common.input, &au->units[i]);
+            if (err < 0)
+                return err;
             err = h265_metadata_update_vps(bsf, au->units[i].content);
             if (err < 0)
                 return err;
         }
         if (au->units[i].type == HEVC_NAL_SPS) {
+            err = ff_cbs_make_unit_writable(ctx->common.input, &au->units[i]);
+            if (err < 0)
+                return err;
             err = h265_metadata_update_sps(bsf, au->units[i].content);
             if (err < 0)
                 return err;
@@ -401,10 +407,29 @@ static const CBSBSFType h265_metadata_type = {
     .fragment_name   = "access unit",
     .unit_name       = "NAL unit",
     .update_fragment = &h265_metadata_update_fragment,
+    .passthrough_unmodified = 1,
+};
+
+static const CodedBitstreamUnitType h265_metadata_decompose_ps[] = {
+    HEVC_NAL_VPS,
+    HEVC_NAL_SPS,
+    HEVC_NAL_PPS,
 };
 
 static int h265_metadata_init(AVBSFContext *bsf)
 {
+    H265MetadataContext *ctx = bsf->priv_data;
+
+    // In passthrough mode, slices are only needed to make new AUDs:
+    // otherwise only the parameter sets are decomposed and everything
+    // else passes through.
+    if (ctx->common.passthrough && ctx->aud != BSF_ELEMENT_INSERT) {
+        ctx->common.decompose_unit_types =
+            h265_metadata_decompose_ps;
+        ctx->common.nb_decompose_unit_types =
+            FF_ARRAY_ELEMS(h265_metadata_decompose_ps);
+    }
+
     return ff_cbs_bsf_generic_init(bsf, &h265_metadata_type);
 }
 
@@ -484,6 +509,10 @@ static const AVOption h265_metadata_options[] = {
     { LEVEL("8.5", 255) },
 #undef LEVEL
 
+    { "passthrough", "Pass unmodified NAL units through without rewriting them",
+        OFFSET(common.passthrough), AV_OPT_TYPE_BOOL,
+        { .i64 = 0 }, 0, 1, FLAGS },
+
     { NULL }
 };
 
@@ -1054,8 +1054,9 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
     ptrdiff_t stride = s->frame->linesize[c_idx];
     int hshift = s->ps.sps->hshift[c_idx];
     int vshift = s->ps.sps->vshift[c_idx];
-    uint8_t *dst = &s->frame->data[c_idx][(y0 >> vshift) * stride +
-                                          ((x0 >> hshift) << s->ps.sps->pixel_shift)];
+    int lowres = s->avctx->lowres;
+    uint8_t *dst = &s->frame->data[c_idx][((y0 >> vshift) >> lowres) * stride +
+                                          (((x0 >> hshift) >> lowres) << s->ps.sps->pixel_shift)];
     int16_t *coeffs = (int16_t*)(c_idx ? lc->edge_emu_buffer2 : lc->edge_emu_buffer);
     uint8_t significant_coeff_group_flag[8][8] = {{0}};
     int explicit_rdpcm_flag = 0;
@@ -1535,7 +1536,10 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
             coeffs[i] = coeffs[i] + ((lc->tu.res_scale_val * coeffs_y[i]) >> 3);
         }
     }
-    s->hevcdsp.add_residual[log2_trafo_size-2](dst, coeffs, stride);
+    if (lowres)
+        ff_hevc_add_residual_lowres(dst, stride, coeffs, trafo_size, lowres);
+    else
+        s->hevcdsp.add_residual[log2_trafo_size-2](dst, coeffs, stride);
 }
 
 void ff_hevc_hls_mvd_coding(HEVCContext *s, int x0, int y0, int log2_cb_size)
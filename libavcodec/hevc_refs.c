@@ -167,6 +167,12 @@ int ff_hevc_set_new_ref(HEVCContext *s, AVFrame **frame, int poc)
     ref->frame->crop_right  = s->ps.sps->output_window.right_offset;
     ref->frame->crop_top    = s->ps.sps->output_window.top_offset;
     ref->frame->crop_bottom = s->ps.sps->output_window.bottom_offset;
+    if (s->avctx->lowres) {
+        ref->frame->crop_left   >>= s->avctx->lowres;
+        ref->frame->crop_right  >>= s->avctx->lowres;
+        ref->frame->crop_top    >>= s->avctx->lowres;
+        ref->frame->crop_bottom >>= s->avctx->lowres;
+    }
 
     return 0;
 }
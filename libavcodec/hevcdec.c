@@ -327,6 +327,12 @@ static void export_stream_params(HEVCContext *s, const HEVCSPS *sps)
     avctx->coded_height        = sps->height;
     avctx->width               = sps->width  - ow->left_offset - ow->right_offset;
     avctx->height              = sps->height - ow->top_offset  - ow->bottom_offset;
+    if (avctx->lowres) {
+        avctx->width  = AV_CEIL_RSHIFT(sps->width,  avctx->lowres) -
+                        (ow->left_offset >> avctx->lowres) - (ow->right_offset  >> avctx->lowres);
+        avctx->height = AV_CEIL_RSHIFT(sps->height, avctx->lowres) -
+                        (ow->top_offset  >> avctx->lowres) - (ow->bottom_offset >> avctx->lowres);
+    }
     avctx->has_b_frames        = sps->temporal_layer[sps->max_sub_layers - 1].num_reorder_pics;
     avctx->profile             = sps->ptl.general_ptl.profile_idc;
     avctx->level               = sps->ptl.general_ptl.level_idc;
@@ -485,6 +491,11 @@ static int set_sps(HEVCContext *s, const HEVCSPS *sps,
     if (!sps)
         return 0;
 
+    if (s->avctx->lowres && (sps->bit_depth > 8 || sps->chroma_format_idc > 1)) {
+        avpriv_request_sample(s->avctx, "lowres with high bit depth, 4:2:2 or 4:4:4");
+        return AVERROR_PATCHWELCOME;
+    }
+
     ret = pic_arrays_init(s, sps);
     if (ret < 0)
         goto fail;
@@ -494,6 +505,8 @@ static int set_sps(HEVCContext *s, const HEVCSPS *sps,
     s->avctx->pix_fmt = pix_fmt;
 
     ff_hevc_pred_init(&s->hpc,     sps->bit_depth);
+    if (s->avctx->lowres)
+        ff_hevc_pred_init_lowres(&s->hpc);
     ff_hevc_dsp_init (&s->hevcdsp, sps->bit_depth);
     ff_videodsp_init (&s->vdsp,    sps->bit_depth);
 
@@ -877,12 +890,17 @@ static int hls_slice_header(HEVCContext *s)
         } else {
             sh->slice_loop_filter_across_slices_enabled_flag = s->ps.pps->seq_loop_filter_across_slices_enabled_flag;
         }
+
+        /* lowres pictures are not loop filtered, so skip the edge setup */
+        s->deblocking_disabled = sh->disable_deblocking_filter_flag ||
+                                 s->avctx->lowres;
     } else if (!s->slice_initialized) {
         av_log(s->avctx, AV_LOG_ERROR, "Independent slice segment missing.\n");
         return AVERROR_INVALIDDATA;
     }
 
     sh->num_entry_point_offsets = 0;
+    s->enable_parallel_tiles    = 0;
     if (s->ps.pps->tiles_enabled_flag || s->ps.pps->entropy_coding_sync_enabled_flag) {
         unsigned num_entry_point_offsets = get_ue_golomb_long(gb);
         // It would be possible to bound this tighter but this here is simpler
@@ -917,8 +935,12 @@ static int hls_slice_header(HEVCContext *s)
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
             if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
+                if (!s->ps.pps->entropy_coding_sync_enabled_flag) {
+                    s->enable_parallel_tiles = 1;
+                } else {
+                    s->enable_parallel_tiles = 0;
+                    s->threads_number = 1;
+                }
             } else
                 s->enable_parallel_tiles = 0;
         } else
@@ -1410,7 +1432,7 @@ do {
                     s->cbf_luma[y_tu * min_tu_width + x_tu] = 1;
                 }
         }
-        if (!s->sh.disable_deblocking_filter_flag) {
+        if (!s->deblocking_disabled) {
             ff_hevc_deblocking_boundary_strengths(s, x0, y0, log2_trafo_size);
             if (s->ps.pps->transquant_bypass_enable_flag &&
                 lc->cu.cu_transquant_bypass_flag)
@@ -1420,6 +1442,44 @@ do {
     return 0;
 }
 
+void ff_hevc_put_lowres(uint8_t *dst, ptrdiff_t dst_stride,
+                        const uint8_t *src, ptrdiff_t src_stride,
+                        int w, int h, int lowres)
+{
+    const int step = 1 << lowres;
+    int x, y, i, j;
+
+    for (y = 0; y < h; y += step) {
+        for (x = 0; x < w; x += step) {
+            int sum = 0;
+            for (j = 0; j < step; j++)
+                for (i = 0; i < step; i++)
+                    sum += src[(y + j) * src_stride + x + i];
+            dst[x >> lowres] = (sum + (1 << (2 * lowres - 1))) >> (2 * lowres);
+        }
+        dst += dst_stride;
+    }
+}
+
+void ff_hevc_add_residual_lowres(uint8_t *dst, ptrdiff_t stride,
+                                 const int16_t *res, int size, int lowres)
+{
+    const int step = 1 << lowres;
+    int x, y, i, j;
+
+    for (y = 0; y < size; y += step) {
+        for (x = 0; x < size; x += step) {
+            int sum = 0;
+            for (j = 0; j < step; j++)
+                for (i = 0; i < step; i++)
+                    sum += res[(y + j) * size + x + i];
+            dst[x >> lowres] = av_clip_uint8(dst[x >> lowres] +
+                                             ((sum + (1 << (2 * lowres - 1))) >> (2 * lowres)));
+        }
+        dst += stride;
+    }
+}
+
 static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
 {
     HEVCLocalContext *lc = s->HEVClc;
@@ -1439,13 +1499,31 @@ static int hls_pcm_sample(HEVCContext *s, int x0, int y0, int log2_cb_size)
     const uint8_t *pcm = skip_bytes(&lc->cc, (length + 7) >> 3);
     int ret;
 
-    if (!s->sh.disable_deblocking_filter_flag)
+    if (!s->deblocking_disabled)
         ff_hevc_deblocking_boundary_strengths(s, x0, y0, log2_cb_size);
 
     ret = init_get_bits(&gb, pcm, length);
     if (ret < 0)
         return ret;
 
+    if (s->avctx->lowres) {
+        const int lowres = s->avctx->lowres;
+        int c_idx;
+
+        for (c_idx = 0; c_idx < (s->ps.sps->chroma_format_idc ? 3 : 1); c_idx++) {
+            int w = cb_size >> s->ps.sps->hshift[c_idx];
+            int h = cb_size >> s->ps.sps->vshift[c_idx];
+            ptrdiff_t stride = s->frame->linesize[c_idx];
+            uint8_t *dst = &s->frame->data[c_idx][((y0 >> s->ps.sps->vshift[c_idx]) >> lowres) * stride +
+                                                  ((x0 >> s->ps.sps->hshift[c_idx]) >> lowres)];
+
+            s->hevcdsp.put_pcm(lc->edge_emu_buffer, w, w, h, &gb,
+                               c_idx ? s->ps.sps->pcm.bit_depth_chroma : s->ps.sps->pcm.bit_depth);
+            ff_hevc_put_lowres(dst, stride, lc->edge_emu_buffer, w, w, h, lowres);
+        }
+        return 0;
+    }
+
     s->hevcdsp.put_pcm(dst0, stride0, cb_size, cb_size,     &gb, s->ps.sps->pcm.bit_depth);
     if (s->ps.sps->chroma_format_idc) {
         s->hevcdsp.put_pcm(dst1, stride1,
@@ -1794,6 +1872,124 @@ static void hevc_await_progress(HEVCContext *s, HEVCFrame *ref,
     }
 }
 
+/**
+ * Lowres motion compensation of one prediction block direction:
+ * bilinear interpolation at 1/8 sample precision from the reduced size
+ * reference. xp and yp are the block position in full size plane samples,
+ * w and h the lowres block size.
+ */
+static void mc_dir_lowres(HEVCContext *s, uint8_t *dst, ptrdiff_t dststride,
+                          const AVFrame *ref, int c_idx, const Mv *mv,
+                          int xp, int yp, int w, int h)
+{
+    HEVCLocalContext *lc = s->HEVClc;
+    const int lowres     = s->avctx->lowres;
+    int hshift           = s->ps.sps->hshift[c_idx];
+    int vshift           = s->ps.sps->vshift[c_idx];
+    int pic_width        = AV_CEIL_RSHIFT(s->ps.sps->width  >> hshift, lowres);
+    int pic_height       = AV_CEIL_RSHIFT(s->ps.sps->height >> vshift, lowres);
+    int sx               = (((xp << (2 + hshift)) + mv->x) * (2 >> hshift)) >> lowres;
+    int sy               = (((yp << (2 + vshift)) + mv->y) * (2 >> vshift)) >> lowres;
+    int mx               = sx & 7;
+    int my               = sy & 7;
+    int a                = (8 - mx) * (8 - my);
+    int b                =      mx  * (8 - my);
+    int c                = (8 - mx) *      my;
+    int d                =      mx  *      my;
+    ptrdiff_t srcstride  = ref->linesize[c_idx];
+    const uint8_t *src;
+    int x, y;
+
+    sx >>= 3;
+    sy >>= 3;
+    src = ref->data[c_idx] + sy * srcstride + sx;
+
+    if (sx < 0 || sy < 0 || sx + w >= pic_width || sy + h >= pic_height) {
+        s->vdsp.emulated_edge_mc(lc->edge_emu_buffer, src,
+                                 EDGE_EMU_BUFFER_STRIDE, srcstride,
+                                 w + 1, h + 1, sx, sy, pic_width, pic_height);
+        src       = lc->edge_emu_buffer;
+        srcstride = EDGE_EMU_BUFFER_STRIDE;
+    }
+
+    for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++)
+            dst[x] = (a * src[x]             + b * src[x + 1] +
+                      c * src[x + srcstride] + d * src[x + srcstride + 1] + 32) >> 6;
+        src += srcstride;
+        dst += dststride;
+    }
+}
+
+static void hevc_mc_lowres(HEVCContext *s, int x0, int y0, int nPbW, int nPbH,
+                           const MvField *current_mv,
+                           HEVCFrame *ref0, HEVCFrame *ref1)
+{
+    const int lowres = s->avctx->lowres;
+    int weight_flag  = (s->sh.slice_type == HEVC_SLICE_P && s->ps.pps->weighted_pred_flag) ||
+                       (s->sh.slice_type == HEVC_SLICE_B && s->ps.pps->weighted_bipred_flag);
+    uint8_t pred[2][(MAX_PB_SIZE / 2) * (MAX_PB_SIZE / 2)];
+    int c_idx, list, x, y;
+
+    for (c_idx = 0; c_idx < (s->ps.sps->chroma_format_idc ? 3 : 1); c_idx++) {
+        int hshift     = s->ps.sps->hshift[c_idx];
+        int vshift     = s->ps.sps->vshift[c_idx];
+        int xp         = x0 >> hshift;
+        int yp         = y0 >> vshift;
+        int xl         = xp >> lowres;
+        int yl         = yp >> lowres;
+        /* blocks narrower than a lowres sample still cover one */
+        int w          = ((xp + (nPbW >> hshift) + (1 << lowres) - 1) >> lowres) - xl;
+        int h          = ((yp + (nPbH >> vshift) + (1 << lowres) - 1) >> lowres) - yl;
+        ptrdiff_t stride = s->frame->linesize[c_idx];
+        uint8_t *dst   = s->frame->data[c_idx] + yl * stride + xl;
+        int denom      = c_idx ? s->sh.chroma_log2_weight_denom : s->sh.luma_log2_weight_denom;
+        int wt[2] = { 0 }, o[2] = { 0 };
+
+        for (list = 0; list < 2; list++) {
+            const HEVCFrame *ref = list ? ref1 : ref0;
+            int ref_idx = current_mv->ref_idx[list];
+
+            if (!(current_mv->pred_flag & (PF_L0 << list)))
+                continue;
+            mc_dir_lowres(s, pred[list], w, ref->frame, c_idx,
+                          &current_mv->mv[list], xp, yp, w, h);
+            if (!c_idx) {
+                wt[list] = list ? s->sh.luma_weight_l1[ref_idx] : s->sh.luma_weight_l0[ref_idx];
+                o[list]  = list ? s->sh.luma_offset_l1[ref_idx] : s->sh.luma_offset_l0[ref_idx];
+            } else {
+                wt[list] = list ? s->sh.chroma_weight_l1[ref_idx][c_idx - 1] :
+                                  s->sh.chroma_weight_l0[ref_idx][c_idx - 1];
+                o[list]  = list ? s->sh.chroma_offset_l1[ref_idx][c_idx - 1] :
+                                  s->sh.chroma_offset_l0[ref_idx][c_idx - 1];
+            }
+        }
+
+        /* same arithmetic as the 8-bit put_hevc_*_w functions */
+        for (y = 0; y < h; y++) {
+            const uint8_t *p0 = pred[0] + y * w;
+            const uint8_t *p1 = pred[1] + y * w;
+
+            if (current_mv->pred_flag == PF_BI) {
+                for (x = 0; x < w; x++)
+                    dst[x] = weight_flag ?
+                             av_clip_uint8((p0[x] * wt[0] + p1[x] * wt[1] +
+                                            ((o[0] + o[1] + 1) << denom)) >> (denom + 1)) :
+                             (p0[x] + p1[x] + 1) >> 1;
+            } else {
+                list = current_mv->pred_flag == PF_L1;
+                p0   = pred[list] + y * w;
+                for (x = 0; x < w; x++)
+                    dst[x] = weight_flag ?
+                             av_clip_uint8(((p0[x] * wt[list] * 64 + (1 << (denom + 5))) >>
+                                            (denom + 6)) + o[list]) :
+                             p0[x];
+            }
+            dst += stride;
+        }
+    }
+}
+
 static void hevc_luma_mv_mvp_mode(HEVCContext *s, int x0, int y0, int nPbW,
                                   int nPbH, int log2_cb_size, int part_idx,
                                   int merge_idx, MvField *mv)
@@ -1903,6 +2099,11 @@ static void hls_prediction_unit(HEVCContext *s, int x0, int y0,
         hevc_await_progress(s, ref1, &current_mv.mv[1], y0, nPbH);
     }
 
+    if (s->avctx->lowres) {
+        hevc_mc_lowres(s, x0, y0, nPbW, nPbH, &current_mv, ref0, ref1);
+        return;
+    }
+
     if (current_mv.pred_flag == PF_L0) {
         int x0_c = x0 >> s->ps.sps->hshift[1];
         int y0_c = y0 >> s->ps.sps->vshift[1];
@@ -2203,7 +2404,7 @@ static int hls_coding_unit(HEVCContext *s, int x0, int y0, int log2_cb_size)
         hls_prediction_unit(s, x0, y0, cb_size, cb_size, log2_cb_size, 0, idx);
         intra_prediction_unit_default_value(s, x0, y0, log2_cb_size);
 
-        if (!s->sh.disable_deblocking_filter_flag)
+        if (!s->deblocking_disabled)
             ff_hevc_deblocking_boundary_strengths(s, x0, y0, log2_cb_size);
     } else {
         int pcm_flag = 0;
@@ -2291,7 +2492,7 @@ static int hls_coding_unit(HEVCContext *s, int x0, int y0, int log2_cb_size)
                 if (ret < 0)
                     return ret;
             } else {
-                if (!s->sh.disable_deblocking_filter_flag)
+                if (!s->deblocking_disabled)
                     ff_hevc_deblocking_boundary_strengths(s, x0, y0, log2_cb_size);
             }
         }
@@ -2603,6 +2804,110 @@ error:
     return ret;
 }
 
+static int hls_decode_entry_tile(AVCodecContext *avctxt, void *input_tile, int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data   = 1;
+    int *tile_p     = input_tile;
+    int tile        = tile_p[job];
+    int ctb_addr_ts = s1->ps.pps->ctb_addr_rs_to_ts[s1->ps.pps->tile_pos_rs[tile]];
+    int ctb_addr_rs = s1->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+    int ret;
+
+    s = s1->sList[self_id];
+    lc = s->HEVClc;
+
+    if (job) {
+        ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+        if (ret < 0)
+            goto error;
+    } else if (lc != s1->HEVClc) {
+        lc->gb = s1->HEVClc->gb;
+    }
+    lc->end_of_tiles_x = s->ps.sps->width;
+
+    while (more_data && ctb_addr_ts < s->ps.sps->ctb_size &&
+           s->ps.pps->tile_id[ctb_addr_ts] == tile) {
+        int x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        int y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+
+        if (atomic_load(&s1->wpp_err))
+            return 0;
+
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+        if (!job && ctb_addr_ts == s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs]) {
+            int idxX = s->ps.pps->col_idxX[x_ctb >> s->ps.sps->log2_ctb_size];
+            lc->end_of_tiles_x = x_ctb + (s->ps.pps->column_width[idxX] << s->ps.sps->log2_ctb_size);
+        }
+
+        ret = ff_hevc_cabac_init(s, ctb_addr_ts, 0);
+        if (ret < 0)
+            goto error;
+
+        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+        if (ctb_addr_ts < s->ps.sps->ctb_size)
+            ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+    }
+
+    if (job != s->sh.num_entry_point_offsets) {
+        if (!more_data) {
+            ret = AVERROR_INVALIDDATA;
+            goto error;
+        }
+        return 0;
+    }
+    return ctb_addr_ts;
+error:
+    s->tab_slice_address[ctb_addr_rs] = -1;
+    atomic_store(&s1->wpp_err, 1);
+    return ret;
+}
+
+/**
+ * Run the in-loop filters of a slice segment whose tiles were decoded in
+ * parallel, in the order the serial decoder would have run them.
+ */
+static void hls_filter_tiles(HEVCContext *s, int ctb_addr_ts_end)
+{
+    int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
+    int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int x_ctb = 0, y_ctb = 0, i;
+
+    for (i = ctb_addr_ts; i < ctb_addr_ts_end; i++) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[i];
+
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, i);
+        ff_hevc_deblocking_boundary_strengths_tile(s, x_ctb, y_ctb);
+    }
+
+    for (i = ctb_addr_ts; i < ctb_addr_ts_end; i++) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[i];
+
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+    }
+
+    if (x_ctb + ctb_size >= s->ps.sps->width &&
+        y_ctb + ctb_size >= s->ps.sps->height)
+        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+}
+
 static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
@@ -2620,7 +2925,26 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         return AVERROR(ENOMEM);
     }
 
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+    if (s->enable_parallel_tiles) {
+        int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+        int tile        = s->ps.pps->tile_id[ctb_addr_ts];
+
+        // only segments made of whole tiles can be split at the entry
+        // points, decode the others serially
+        if (s->ps.pps->tile_pos_rs[tile] != s->sh.slice_ctb_addr_rs ||
+            tile + s->sh.num_entry_point_offsets >=
+            s->ps.pps->num_tile_columns * s->ps.pps->num_tile_rows) {
+            int threads_number = s->threads_number;
+
+            av_free(ret);
+            av_free(arg);
+            s->enable_parallel_tiles = 0;
+            s->threads_number        = 1;
+            res = hls_slice_data(s);
+            s->threads_number        = threads_number;
+            return res;
+        }
+    } else if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
         av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
             s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
             s->ps.sps->ctb_width, s->ps.sps->ctb_height
@@ -2696,8 +3020,50 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         ret[i] = 0;
     }
 
-    if (s->ps.pps->entropy_coding_sync_enabled_flag)
+    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
         s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    } else if (s->enable_parallel_tiles) {
+        int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+        int tile        = s->ps.pps->tile_id[ctb_addr_ts];
+
+        if (!ctb_addr_ts && s->sh.dependent_slice_segment_flag) {
+            av_log(s->avctx, AV_LOG_ERROR, "Impossible initial tile.\n");
+            res = AVERROR_INVALIDDATA;
+            goto error;
+        }
+
+        if (s->sh.dependent_slice_segment_flag) {
+            int prev_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts - 1];
+            if (s->tab_slice_address[prev_rs] != s->sh.slice_addr) {
+                av_log(s->avctx, AV_LOG_ERROR, "Previous slice segment missing\n");
+                res = AVERROR_INVALIDDATA;
+                goto error;
+            }
+        }
+
+        // the slice segment covers whole tiles, so neighbouring tiles can
+        // see its slice address before they are decoded
+        for (i = ctb_addr_ts; i < s->ps.sps->ctb_size &&
+             s->ps.pps->tile_id[i] <= tile + s->sh.num_entry_point_offsets; i++)
+            s->tab_slice_address[s->ps.pps->ctb_addr_ts_to_rs[i]] = s->sh.slice_addr;
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
+            arg[i] = tile + i;
+
+        s->avctx->execute2(s->avctx, hls_decode_entry_tile, arg, ret, s->sh.num_entry_point_offsets + 1);
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
+            if (ret[i] < 0) {
+                res = ret[i];
+                goto error;
+            }
+        }
+        if (atomic_load(&s->wpp_err)) {
+            res = AVERROR_INVALIDDATA;
+            goto error;
+        }
+        hls_filter_tiles(s, ret[s->sh.num_entry_point_offsets]);
+    }
 
     for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         res += ret[i];
@@ -3140,6 +3506,101 @@ fail:
     return 0;
 }
 
+/**
+ * Check from the NAL unit headers whether a packet can be dropped when only
+ * keyframes are decoded: it has slices, but no IRAP picture, parameter
+ * sets or end of sequence.  If so, the POC of the dropped picture is still
+ * tracked, from the start of its first slice segment header, so that the
+ * POCs of following CRA pictures are derived correctly.
+ */
+static int skip_nonkey_packet(HEVCContext *s, const uint8_t *buf, int length)
+{
+    uint8_t hdr[32 + AV_INPUT_BUFFER_PADDING_SIZE] = { 0 };
+    const uint8_t *nal, *slice = NULL;
+    const HEVCPPS *pps;
+    const HEVCSPS *sps;
+    GetBitContext gb;
+    int pos = 0, nal_size, slice_size = 0;
+    int i, n, zeros, type, temporal_id, pps_id, poc;
+
+    while (ff_h2645_find_raw_nal(buf, length, s->is_nalff, s->nal_length_size,
+                                 &pos, &nal, &nal_size)) {
+        if (nal_size < 2 || ((nal[0] & 1) | (nal[1] >> 3)))
+            continue;
+
+        switch ((nal[0] >> 1) & 0x3f) {
+        case HEVC_NAL_TRAIL_N:
+        case HEVC_NAL_TRAIL_R:
+        case HEVC_NAL_TSA_N:
+        case HEVC_NAL_TSA_R:
+        case HEVC_NAL_STSA_N:
+        case HEVC_NAL_STSA_R:
+        case HEVC_NAL_RADL_N:
+        case HEVC_NAL_RADL_R:
+        case HEVC_NAL_RASL_N:
+        case HEVC_NAL_RASL_R:
+            if (!slice) {
+                slice      = nal;
+                slice_size = nal_size;
+            }
+            break;
+        case HEVC_NAL_AUD:
+        case HEVC_NAL_SEI_PREFIX:
+        case HEVC_NAL_SEI_SUFFIX:
+        case HEVC_NAL_FD_NUT:
+            break;
+        default:
+            return 0;
+        }
+    }
+    if (!slice)
+        return 0;
+
+    s->last_eos = s->eos;
+    s->eos      = 0;
+
+    for (i = 2, n = 0, zeros = 0; i < slice_size && n < 32; i++) {
+        if (zeros >= 2 && slice[i] == 3) {
+            zeros = 0;
+            continue;
+        }
+        hdr[n++] = slice[i];
+        zeros    = slice[i] ? 0 : zeros + 1;
+    }
+    init_get_bits8(&gb, hdr, n);
+
+    type        = (slice[0] >> 1) & 0x3f;
+    temporal_id = (slice[1] & 7) - 1;
+
+    if (!get_bits1(&gb)) // first_slice_segment_in_pic_flag
+        return 1;
+    pps_id = get_ue_golomb_long(&gb);
+    if (pps_id >= HEVC_MAX_PPS_COUNT || !s->ps.pps_list[pps_id])
+        return 1;
+    pps = (const HEVCPPS*)s->ps.pps_list[pps_id]->data;
+    if (!s->ps.sps_list[pps->sps_id])
+        return 1;
+    sps = (const HEVCSPS*)s->ps.sps_list[pps->sps_id]->data;
+
+    skip_bits(&gb, pps->num_extra_slice_header_bits);
+    get_ue_golomb_long(&gb); // slice_type
+    if (pps->output_flag_present_flag)
+        skip_bits1(&gb);
+    if (sps->separate_colour_plane_flag)
+        skip_bits(&gb, 2);
+
+    poc    = ff_hevc_compute_poc(sps, s->pocTid0, get_bits(&gb, sps->log2_max_poc_lsb), type);
+    s->poc = poc;
+    if (temporal_id == 0 &&
+        type != HEVC_NAL_TRAIL_N && type != HEVC_NAL_TSA_N  &&
+        type != HEVC_NAL_STSA_N  && type != HEVC_NAL_RADL_N &&
+        type != HEVC_NAL_RADL_R  && type != HEVC_NAL_RASL_N &&
+        type != HEVC_NAL_RASL_R)
+        s->pocTid0 = poc;
+
+    return 1;
+}
+
 static int decode_nal_units(HEVCContext *s, const uint8_t *buf, int length)
 {
     int i, ret = 0;
@@ -3325,6 +3786,13 @@ static int hevc_decode_frame(AVCodecContext *avctx, void *data, int *got_output,
     }
 
     s->ref = NULL;
+
+    /* With skip_frame=nokey, drop whole packets without keyframes before
+     * splitting them into NAL units. */
+    if (avctx->skip_frame >= AVDISCARD_NONKEY && !avctx->hwaccel &&
+        skip_nonkey_packet(s, avpkt->data, avpkt->size))
+        return avpkt->size;
+
     ret    = decode_nal_units(s, avpkt->data, avpkt->size);
     if (ret < 0)
         return ret;
@@ -3339,7 +3807,7 @@ static int hevc_decode_frame(AVCodecContext *avctx, void *data, int *got_output,
     } else {
         /* verify the SEI checksum */
         if (avctx->err_recognition & AV_EF_CRCCHECK && s->is_decoded &&
-            s->sei.picture_hash.is_md5) {
+            s->sei.picture_hash.is_md5 && !avctx->lowres) {
             ret = verify_md5(s, s->ref->frame);
             if (ret < 0 && avctx->err_recognition & AV_EF_EXPLODE) {
                 ff_hevc_unref_frame(s, s->ref, ~0);
@@ -3684,6 +4152,7 @@ AVCodec ff_hevc_decoder = {
     .caps_internal         = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_EXPORTS_CROPPING |
                              FF_CODEC_CAP_ALLOCATE_PROGRESS | FF_CODEC_CAP_INIT_CLEANUP,
     .profiles              = NULL_IF_CONFIG_SMALL(ff_hevc_profiles),
+    .max_lowres            = 2,
     .hw_configs            = (const AVCodecHWConfigInternal *const []) {
 #if CONFIG_HEVC_DXVA2_HWACCEL
                                HWACCEL_DXVA2(hevc),
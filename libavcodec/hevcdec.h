@@ -486,6 +486,12 @@ typedef struct HEVCContext {
     /** 1 if the independent slice segment header was successfully parsed */
     uint8_t slice_initialized;
 
+    /**
+     * 1 if no deblocking is set up for the current slice: it is disabled in
+     * the slice header or the picture is decoded at a lower resolution
+     */
+    uint8_t deblocking_disabled;
+
     AVFrame *frame;
     AVFrame *output_frame;
     uint8_t *sao_pixel_buffer_h[3];
@@ -675,6 +681,12 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+/**
+ * Compute the boundary strengths of the tile edges of a CTB, which are
+ * skipped while tiles are decoded in parallel.
+ */
+void ff_hevc_deblocking_boundary_strengths_tile(HEVCContext *s, int x_ctb,
+                                                int y_ctb);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
@@ -687,6 +699,20 @@ void ff_hevc_hls_residual_coding(HEVCContext *s, int x0, int y0,
 
 void ff_hevc_hls_mvd_coding(HEVCContext *s, int x0, int y0, int log2_cb_size);
 
+/**
+ * Store a w x h block of 8-bit samples into a lowres picture, averaging
+ * each (1 << lowres) x (1 << lowres) square into one output sample.
+ */
+void ff_hevc_put_lowres(uint8_t *dst, ptrdiff_t dst_stride,
+                        const uint8_t *src, ptrdiff_t src_stride,
+                        int w, int h, int lowres);
+/**
+ * Add a size x size residual block to a lowres picture, averaging each
+ * (1 << lowres) x (1 << lowres) square of the residual.
+ */
+void ff_hevc_add_residual_lowres(uint8_t *dst, ptrdiff_t stride,
+                                 const int16_t *res, int size, int lowres);
+
 extern const uint8_t ff_hevc_qpel_extra_before[4];
 extern const uint8_t ff_hevc_qpel_extra_after[4];
 extern const uint8_t ff_hevc_qpel_extra[4];
@@ -78,3 +78,11 @@ void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth)
     if (ARCH_MIPS)
         ff_hevc_pred_init_mips(hpc, bit_depth);
 }
+
+void ff_hevc_pred_init_lowres(HEVCPredContext *hpc)
+{
+    hpc->intra_pred[0] = FUNC(intra_pred_lowres_2, 8);
+    hpc->intra_pred[1] = FUNC(intra_pred_lowres_3, 8);
+    hpc->intra_pred[2] = FUNC(intra_pred_lowres_4, 8);
+    hpc->intra_pred[3] = FUNC(intra_pred_lowres_5, 8);
+}
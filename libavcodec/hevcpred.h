@@ -41,6 +41,11 @@ typedef struct HEVCPredContext {
 } HEVCPredContext;
 
 void ff_hevc_pred_init(HEVCPredContext *hpc, int bit_depth);
+/**
+ * Switch the intra prediction to reduced resolution (AVCodecContext.lowres)
+ * 8-bit pictures, must be called after ff_hevc_pred_init().
+ */
+void ff_hevc_pred_init_lowres(HEVCPredContext *hpc);
 void ff_hevc_pred_init_mips(HEVCPredContext *hpc, int bit_depth);
 
 #endif /* AVCODEC_HEVCPRED_H */
@@ -28,7 +28,7 @@
 #define POS(x, y) src[(x) + stride * (y)]
 
 static av_always_inline void FUNC(intra_pred)(HEVCContext *s, int x0, int y0,
-                                              int log2_size, int c_idx)
+                                              int log2_size, int c_idx, int lowres)
 {
 #define PU(x) \
     ((x) >> s->ps.sps->log2_min_pu_size)
@@ -38,6 +38,8 @@ static av_always_inline void FUNC(intra_pred)(HEVCContext *s, int x0, int y0,
     MVF(PU(x0 + ((x) * (1 << hshift))), PU(y0 + ((y) * (1 << vshift))))
 #define IS_INTRA(x, y) \
     (MVF_PU(x, y).pred_flag == PF_INTRA)
+#define NB(x, y) \
+    src[((x) >> lowres) + stride * ((y) >> lowres)]
 #define MIN_TB_ADDR_ZS(x, y) \
     s->ps.pps->min_tb_addr_zs[(y) * (s->ps.sps->tb_mask+2) + (x)]
 #define EXTEND(ptr, val, len)         \
@@ -88,7 +90,7 @@ do {                                  \
     int cur_tb_addr = MIN_TB_ADDR_ZS(x_tb, y_tb);
 
     ptrdiff_t stride = s->frame->linesize[c_idx] / sizeof(pixel);
-    pixel *src = (pixel*)s->frame->data[c_idx] + x + y * stride;
+    pixel *src = (pixel*)s->frame->data[c_idx] + (x >> lowres) + (y >> lowres) * stride;
 
     int min_pu_width = s->ps.sps->min_pu_width;
 
@@ -104,6 +106,8 @@ do {                                  \
     pixel  *top           = top_array  + 1;
     pixel  *filtered_left = filtered_left_array + 1;
     pixel  *filtered_top  = filtered_top_array  + 1;
+    pixel  *dst           = src;
+    ptrdiff_t dst_stride  = stride;
     int cand_bottom_left = lc->na.cand_bottom_left && cur_tb_addr > MIN_TB_ADDR_ZS( x_tb - 1, (y_tb + size_in_tbs_v + spin) & s->ps.sps->tb_mask);
     int cand_left        = lc->na.cand_left;
     int cand_up_left     = lc->na.cand_up_left;
@@ -164,23 +168,32 @@ do {                                  \
         top[-1] = 128;
     }
     if (cand_up_left) {
-        left[-1] = POS(-1, -1);
+        left[-1] = NB(-1, -1);
         top[-1]  = left[-1];
     }
-    if (cand_up)
-        memcpy(top, src - stride, size * sizeof(pixel));
+    if (cand_up) {
+        if (lowres)
+            for (i = 0; i < size; i++)
+                top[i] = NB(i, -1);
+        else
+            memcpy(top, src - stride, size * sizeof(pixel));
+    }
     if (cand_up_right) {
-        memcpy(top + size, src - stride + size, size * sizeof(pixel));
-        EXTEND(top + size + top_right_size, POS(size + top_right_size - 1, -1),
+        if (lowres)
+            for (i = size; i < 2 * size; i++)
+                top[i] = NB(i, -1);
+        else
+            memcpy(top + size, src - stride + size, size * sizeof(pixel));
+        EXTEND(top + size + top_right_size, NB(size + top_right_size - 1, -1),
                size - top_right_size);
     }
     if (cand_left)
         for (i = 0; i < size; i++)
-            left[i] = POS(-1, i);
+            left[i] = NB(-1, i);
     if (cand_bottom_left) {
         for (i = size; i < size + bottom_left_size; i++)
-            left[i] = POS(-1, i);
-        EXTEND(left + size + bottom_left_size, POS(-1, size + bottom_left_size - 1),
+            left[i] = NB(-1, i);
+        EXTEND(left + size + bottom_left_size, NB(-1, size + bottom_left_size - 1),
                size - bottom_left_size);
     }
 
@@ -328,27 +341,37 @@ do {                                  \
         }
     }
 
+    // Lowres blocks are predicted at full size and then downscaled
+    if (lowres) {
+        dst        = (pixel *)s->HEVClc->edge_emu_buffer2;
+        dst_stride = size;
+    }
+
     switch (mode) {
     case INTRA_PLANAR:
-        s->hpc.pred_planar[log2_size - 2]((uint8_t *)src, (uint8_t *)top,
-                                          (uint8_t *)left, stride);
+        s->hpc.pred_planar[log2_size - 2]((uint8_t *)dst, (uint8_t *)top,
+                                          (uint8_t *)left, dst_stride);
         break;
     case INTRA_DC:
-        s->hpc.pred_dc((uint8_t *)src, (uint8_t *)top,
-                       (uint8_t *)left, stride, log2_size, c_idx);
+        s->hpc.pred_dc((uint8_t *)dst, (uint8_t *)top,
+                       (uint8_t *)left, dst_stride, log2_size, c_idx);
         break;
     default:
-        s->hpc.pred_angular[log2_size - 2]((uint8_t *)src, (uint8_t *)top,
-                                           (uint8_t *)left, stride, c_idx,
+        s->hpc.pred_angular[log2_size - 2]((uint8_t *)dst, (uint8_t *)top,
+                                           (uint8_t *)left, dst_stride, c_idx,
                                            mode);
         break;
     }
+
+    if (lowres)
+        ff_hevc_put_lowres((uint8_t *)src, stride, (uint8_t *)dst, dst_stride,
+                           size, size, lowres);
 }
 
 #define INTRA_PRED(size)                                                            \
 static void FUNC(intra_pred_ ## size)(HEVCContext *s, int x0, int y0, int c_idx)    \
 {                                                                                   \
-    FUNC(intra_pred)(s, x0, y0, size, c_idx);                                       \
+    FUNC(intra_pred)(s, x0, y0, size, c_idx, 0);                                    \
 }
 
 INTRA_PRED(2)
@@ -358,6 +381,22 @@ INTRA_PRED(5)
 
 #undef INTRA_PRED
 
+#if BIT_DEPTH == 8
+#define INTRA_PRED_LOWRES(size)                                                     \
+static void FUNC(intra_pred_lowres_ ## size)(HEVCContext *s, int x0, int y0,        \
+                                             int c_idx)                             \
+{                                                                                   \
+    FUNC(intra_pred)(s, x0, y0, size, c_idx, s->avctx->lowres);                     \
+}
+
+INTRA_PRED_LOWRES(2)
+INTRA_PRED_LOWRES(3)
+INTRA_PRED_LOWRES(4)
+INTRA_PRED_LOWRES(5)
+
+#undef INTRA_PRED_LOWRES
+#endif
+
 static av_always_inline void FUNC(pred_planar)(uint8_t *_src, const uint8_t *_top,
                                   const uint8_t *_left, ptrdiff_t stride,
                                   int trafo_size)
@@ -546,6 +585,7 @@ static void FUNC(pred_angular_3)(uint8_t *src, const uint8_t *top,
 #undef IS_INTRA
 #undef MVF_PU
 #undef MVF
+#undef NB
 #undef PU
 #undef EXTEND
 #undef MIN_TB_ADDR_ZS
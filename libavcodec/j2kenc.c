@@ -105,6 +105,14 @@ typedef struct {
    double *layer_rates;
 } Jpeg2000Tile;
 
+/* a row of code blocks of one band, the unit of tier-1 slice threading */
+typedef struct {
+    int tileno, compno, reslevelno, bandno;
+    int yy0, yy1;   ///< first and last + 1 line of the row in the DWT output
+    int xx0;        ///< first column of the band in the DWT output
+    int cblkno;     ///< index of the first code block of the row in the precinct
+} Jpeg2000CblkRow;
+
 typedef struct {
     AVClass *class;
     AVCodecContext *avctx;
@@ -129,6 +137,9 @@ typedef struct {
     Jpeg2000QuantStyle  qntsty;
 
     Jpeg2000Tile *tile;
+    Jpeg2000CblkRow *cblk_rows;
+    int nb_cblk_rows;
+    int *job_ret;
     int layer_rates[100];
     uint8_t compression_rate_enc; ///< Is compression done using compression ratio?
 
@@ -502,6 +513,80 @@ static int init_tiles(Jpeg2000EncoderContext *s)
     return 0;
 }
 
+static int init_cblk_rows(Jpeg2000EncoderContext *s)
+{
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    int tileno, compno, reslevelno, bandno, pass;
+
+    /* count the rows in the first pass, fill them in the second */
+    for (pass = 0; pass < 2; pass++) {
+        s->nb_cblk_rows = 0;
+        for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+            for (compno = 0; compno < s->ncomponents; compno++) {
+                Jpeg2000Component *comp = s->tile[tileno].comp + compno;
+
+                for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++) {
+                    Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+
+                    for (bandno = 0; bandno < reslevel->nbands; bandno++) {
+                        Jpeg2000Band *band = reslevel->band + bandno;
+                        Jpeg2000Prec *prec = band->prec;
+                        int cblky, cblkno, y0, yy0, yy1, xx0;
+
+                        if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
+                            continue;
+
+                        yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
+                        y0  = yy0;
+                        yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
+                                    band->coord[1][1]) - band->coord[1][0] + yy0;
+                        if (reslevelno == 0 || bandno == 1)
+                            xx0 = 0;
+                        else
+                            xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
+
+                        for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++) {
+                            if (pass) {
+                                Jpeg2000CblkRow *row = s->cblk_rows + s->nb_cblk_rows;
+                                row->tileno     = tileno;
+                                row->compno     = compno;
+                                row->reslevelno = reslevelno;
+                                row->bandno     = bandno;
+                                row->yy0        = yy0;
+                                row->yy1        = yy1;
+                                row->xx0        = xx0;
+                                row->cblkno     = cblky * prec->nb_codeblocks_width;
+                            }
+                            s->nb_cblk_rows++;
+                            yy0 = yy1;
+                            yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+                        }
+
+                        if (pass) {
+                            for (cblkno = 0; cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height; cblkno++) {
+                                Jpeg2000Cblk *cblk = prec->cblk + cblkno;
+                                cblk->data   = av_malloc(1 + 8192);
+                                cblk->passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof(*cblk->passes));
+                                if (!cblk->data || !cblk->passes)
+                                    return AVERROR(ENOMEM);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (!pass) {
+            s->cblk_rows = av_malloc_array(s->nb_cblk_rows, sizeof(*s->cblk_rows));
+            s->job_ret   = av_malloc_array(FFMAX(s->nb_cblk_rows,
+                                                 s->numXtiles * s->numYtiles * s->ncomponents),
+                                           sizeof(*s->job_ret));
+            if (!s->cblk_rows || !s->job_ret)
+                return AVERROR(ENOMEM);
+        }
+    }
+    return 0;
+}
+
 #define COPY_FRAME(D, PIXEL)                                                                                                \
     static void copy_frame_ ##D(Jpeg2000EncoderContext *s)                                                                  \
     {                                                                                                                       \
@@ -1399,84 +1484,83 @@ static void truncpasses(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile)
     }
 }
 
-static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+static int dwt_tile_comp(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
-    int compno, reslevelno, bandno, ret;
-    Jpeg2000T1Context t1;
-    Jpeg2000CodingStyle *codsty = &s->codsty;
-    for (compno = 0; compno < s->ncomponents; compno++){
-        Jpeg2000Component *comp = s->tile[tileno].comp + compno;
-
-        t1.stride = (1<<codsty->log2_cblk_width) + 2;
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    Jpeg2000Component *comp = s->tile[jobnr / s->ncomponents].comp + jobnr % s->ncomponents;
 
-        av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
-        if ((ret = ff_dwt_encode(&comp->dwt, comp->i_data)) < 0)
-            return ret;
-        av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    return ff_dwt_encode(&comp->dwt, comp->i_data);
+}
 
-        for (reslevelno = 0; reslevelno < codsty->nreslevels; reslevelno++){
-            Jpeg2000ResLevel *reslevel = comp->reslevel + reslevelno;
+static int encode_cblk_row(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    Jpeg2000EncoderContext *s = avctx->priv_data;
+    const Jpeg2000CblkRow *row = s->cblk_rows + jobnr;
+    Jpeg2000CodingStyle *codsty = &s->codsty;
+    Jpeg2000Tile *tile = s->tile + row->tileno;
+    Jpeg2000Component *comp = tile->comp + row->compno;
+    Jpeg2000Band *band = comp->reslevel[row->reslevelno].band + row->bandno;
+    Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
+    int bandpos = row->bandno + (row->reslevelno > 0);
+    int cblkx, cblkno = row->cblkno, xx0, x0, xx1, yy0 = row->yy0, yy1 = row->yy1;
+    Jpeg2000T1Context t1;
 
-            for (bandno = 0; bandno < reslevel->nbands ; bandno++){
-                Jpeg2000Band *band = reslevel->band + bandno;
-                Jpeg2000Prec *prec = band->prec; // we support only 1 precinct per band ATM in the encoder
-                int cblkx, cblky, cblkno=0, xx0, x0, xx1, y0, yy0, yy1, bandpos;
-                yy0 = bandno == 0 ? 0 : comp->reslevel[reslevelno-1].coord[1][1] - comp->reslevel[reslevelno-1].coord[1][0];
-                y0 = yy0;
-                yy1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[1][0] + 1, band->log2_cblk_height) << band->log2_cblk_height,
-                            band->coord[1][1]) - band->coord[1][0] + yy0;
+    t1.stride = (1<<codsty->log2_cblk_width) + 2;
 
-                if (band->coord[0][0] == band->coord[0][1] || band->coord[1][0] == band->coord[1][1])
-                    continue;
+    xx0 = x0 = row->xx0;
+    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
+                band->coord[0][1]) - band->coord[0][0] + xx0;
 
-                bandpos = bandno + (reslevelno > 0);
-
-                for (cblky = 0; cblky < prec->nb_codeblocks_height; cblky++){
-                    if (reslevelno == 0 || bandno == 1)
-                        xx0 = 0;
-                    else
-                        xx0 = comp->reslevel[reslevelno-1].coord[0][1] - comp->reslevel[reslevelno-1].coord[0][0];
-                    x0 = xx0;
-                    xx1 = FFMIN(ff_jpeg2000_ceildivpow2(band->coord[0][0] + 1, band->log2_cblk_width) << band->log2_cblk_width,
-                                band->coord[0][1]) - band->coord[0][0] + xx0;
-
-                    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
-                        int y, x;
-                        if (codsty->transform == FF_DWT53){
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
-                                }
-                            }
-                        } else{
-                            for (y = yy0; y < yy1; y++){
-                                int *ptr = t1.data + (y-yy0)*t1.stride;
-                                for (x = xx0; x < xx1; x++){
-                                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
-                                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
-                                    ptr++;
-                                }
-                            }
-                        }
-                        if (!prec->cblk[cblkno].data)
-                            prec->cblk[cblkno].data = av_malloc(1 + 8192);
-                        if (!prec->cblk[cblkno].passes)
-                            prec->cblk[cblkno].passes = av_malloc_array(JPEG2000_MAX_PASSES, sizeof (*prec->cblk[cblkno].passes));
-                        if (!prec->cblk[cblkno].data || !prec->cblk[cblkno].passes)
-                            return AVERROR(ENOMEM);
-                        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
-                                    bandpos, codsty->nreslevels - reslevelno - 1);
-                        xx0 = xx1;
-                        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
-                    }
-                    yy0 = yy1;
-                    yy1 = FFMIN(yy1 + (1 << band->log2_cblk_height), band->coord[1][1] - band->coord[1][0] + y0);
+    for (cblkx = 0; cblkx < prec->nb_codeblocks_width; cblkx++, cblkno++){
+        int y, x;
+        if (codsty->transform == FF_DWT53){
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr++ = comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x] * (1 << NMSEDEC_FRACBITS);
+                }
+            }
+        } else{
+            for (y = yy0; y < yy1; y++){
+                int *ptr = t1.data + (y-yy0)*t1.stride;
+                for (x = xx0; x < xx1; x++){
+                    *ptr = (comp->i_data[(comp->coord[0][1] - comp->coord[0][0]) * y + x]);
+                    *ptr = (int64_t)*ptr * (int64_t)(16384 * 65536 / band->i_stepsize) >> 15 - NMSEDEC_FRACBITS;
+                    ptr++;
                 }
             }
         }
-        av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+        encode_cblk(s, &t1, prec->cblk + cblkno, tile, xx1 - xx0, yy1 - yy0,
+                    bandpos, codsty->nreslevels - row->reslevelno - 1);
+        xx0 = xx1;
+        xx1 = FFMIN(xx1 + (1 << band->log2_cblk_width), band->coord[0][1] - band->coord[0][0] + x0);
     }
+    return 0;
+}
+
+/* DWT and tier-1 coding of all tiles: first the transform of every tile
+ * component, then the code block rows, each independent of the others. */
+static int encode_tier1(Jpeg2000EncoderContext *s)
+{
+    AVCodecContext *avctx = s->avctx;
+    int i, nb_comps = s->numXtiles * s->numYtiles * s->ncomponents;
+
+    av_log(s->avctx, AV_LOG_DEBUG,"dwt\n");
+    avctx->execute2(avctx, dwt_tile_comp, NULL, s->job_ret, nb_comps);
+    for (i = 0; i < nb_comps; i++)
+        if (s->job_ret[i] < 0)
+            return s->job_ret[i];
+
+    av_log(s->avctx, AV_LOG_DEBUG,"after dwt -> tier1\n");
+    avctx->execute2(avctx, encode_cblk_row, NULL, s->job_ret, s->nb_cblk_rows);
+    av_log(s->avctx, AV_LOG_DEBUG, "after tier1\n");
+
+    return 0;
+}
+
+static int encode_tile(Jpeg2000EncoderContext *s, Jpeg2000Tile *tile, int tileno)
+{
+    int ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "rate control\n");
     if (s->compression_rate_enc)
@@ -1508,6 +1592,8 @@ static void cleanup(Jpeg2000EncoderContext *s)
         av_freep(&s->tile[tileno].layer_rates);
     }
     av_freep(&s->tile);
+    av_freep(&s->cblk_rows);
+    av_freep(&s->job_ret);
 }
 
 static void reinit(Jpeg2000EncoderContext *s)
@@ -1638,6 +1724,9 @@ static int encode_frame(AVCodecContext *avctx, AVPacket *pkt,
     if ((ret = put_com(s, 0)) < 0)
         return ret;
 
+    if ((ret = encode_tier1(s)) < 0)
+        return ret;
+
     for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++){
         uint8_t *psotptr;
         if (!(psotptr = put_sot(s, tileno)))
@@ -1793,6 +1882,8 @@ FF_ENABLE_DEPRECATION_WARNINGS
     init_quantization(s);
     if ((ret=init_tiles(s)) < 0)
         return ret;
+    if ((ret = init_cblk_rows(s)) < 0)
+        return ret;
 
     av_log(s->avctx, AV_LOG_DEBUG, "after init\n");
 
@@ -1848,6 +1939,7 @@ AVCodec ff_jpeg2000_encoder = {
     .init           = j2kenc_init,
     .encode2        = encode_frame,
     .close          = j2kenc_destroy,
+    .capabilities   = AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_YUV444P, AV_PIX_FMT_GRAY8,
         AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
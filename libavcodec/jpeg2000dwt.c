@@ -48,6 +48,11 @@
 #define I_LFTG_X       53274ll
 #define I_PRESHIFT 8
 
+/* Number of columns the forward vertical transforms process together;
+ * each row of the tile is then read and written DWT_COLS values at a time
+ * instead of one value per cache line for every column. */
+#define DWT_COLS 8
+
 static inline void extend53(int *p, int i0, int i1)
 {
     p[i0 - 1] = p[i0 + 1];
@@ -94,11 +99,42 @@ static void sd_1d53(int *p, int i0, int i1)
         p[2*i] += (p[2*i-1] + p[2*i+1] + 2) >> 2;
 }
 
+static void sd_1d53_cols(int *p, int i0, int i1, int n)
+{
+    int i, c;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (c = 0; c < n; c++)
+                p[DWT_COLS + c] <<= 1;
+        return;
+    }
+
+    for (c = 0; c < n; c++) {
+        p[(i0 - 1) * DWT_COLS + c] = p[(i0 + 1) * DWT_COLS + c];
+        p[ i1      * DWT_COLS + c] = p[(i1 - 2) * DWT_COLS + c];
+        p[(i0 - 2) * DWT_COLS + c] = p[(i0 + 2) * DWT_COLS + c];
+        p[(i1 + 1) * DWT_COLS + c] = p[(i1 - 3) * DWT_COLS + c];
+    }
+
+    for (i = ((i0+1)>>1) - 1; i < (i1+1)>>1; i++) {
+        int *d = p + (2 * i + 1) * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] -= (d[c - DWT_COLS] + d[c + DWT_COLS]) >> 1;
+    }
+    for (i = ((i0+1)>>1); i < (i1+1)>>1; i++) {
+        int *d = p + 2 * i * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] += (d[c - DWT_COLS] + d[c + DWT_COLS] + 2) >> 2;
+    }
+}
+
 static void dwt_encode53(DWTContext *s, int *t)
 {
     int lev,
         w = s->linelen[s->ndeclevels-1][0];
     int *line = s->i_linebuf;
+    int *cols = s->i_linebuf + 3 * DWT_COLS;
     line += 3;
 
     for (lev = s->ndeclevels-1; lev >= 0; lev--){
@@ -110,20 +146,23 @@ static void dwt_encode53(DWTContext *s, int *t)
         int *l;
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = cols + mv * DWT_COLS;
+        for (lp = 0; lp < lh; lp += DWT_COLS) {
+            int i, j = 0, c, n = FFMIN(DWT_COLS, lh - lp);
 
             for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
+                for (c = 0; c < n; c++)
+                    l[i * DWT_COLS + c] = t[w*i + lp + c];
 
-            sd_1d53(line, mv, mv + lv);
+            sd_1d53_cols(cols, mv, mv + lv, n);
 
             // copy back and deinterleave
             for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    t[w*j + lp + c] = l[i * DWT_COLS + c];
             for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    t[w*j + lp + c] = l[i * DWT_COLS + c];
         }
 
         // HOR_SD
@@ -245,6 +284,50 @@ static void sd_1d97_int(int *p, int i0, int i1)
         p[2 * i]     += (I_LFTG_DELTA * (p[2 * i - 1] + p[2 * i + 1]) + (1 << 15)) >> 16;
 }
 
+static void sd_1d97_int_cols(int *p, int i0, int i1, int n)
+{
+    int i, c;
+
+    if (i1 <= i0 + 1) {
+        for (c = 0; c < n; c++) {
+            if (i0 == 1)
+                p[DWT_COLS + c] = (p[DWT_COLS + c] * I_LFTG_X + (1<<14)) >> 15;
+            else
+                p[c] = (p[c] * I_LFTG_K + (1<<15)) >> 16;
+        }
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        for (c = 0; c < n; c++) {
+            p[(i0 - i)     * DWT_COLS + c] = p[(i0 + i)     * DWT_COLS + c];
+            p[(i1 + i - 1) * DWT_COLS + c] = p[(i1 - i - 1) * DWT_COLS + c];
+        }
+    }
+    i0++; i1++;
+
+    for (i = (i0>>1) - 2; i < (i1>>1) + 1; i++) {
+        int *d = p + (2 * i + 1) * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] -= (I_LFTG_ALPHA * (d[c - DWT_COLS] + d[c + DWT_COLS]) + (1 << 15)) >> 16;
+    }
+    for (i = (i0>>1) - 1; i < (i1>>1) + 1; i++) {
+        int *d = p + 2 * i * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] -= (I_LFTG_BETA  * (d[c - DWT_COLS] + d[c + DWT_COLS]) + (1 << 15)) >> 16;
+    }
+    for (i = (i0>>1) - 1; i < (i1>>1); i++) {
+        int *d = p + (2 * i + 1) * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] += (I_LFTG_GAMMA * (d[c - DWT_COLS] + d[c + DWT_COLS]) + (1 << 15)) >> 16;
+    }
+    for (i = (i0>>1); i < (i1>>1); i++) {
+        int *d = p + 2 * i * DWT_COLS;
+        for (c = 0; c < n; c++)
+            d[c] += (I_LFTG_DELTA * (d[c - DWT_COLS] + d[c + DWT_COLS]) + (1 << 15)) >> 16;
+    }
+}
+
 static void dwt_encode97_int(DWTContext *s, int *t)
 {
     int lev;
@@ -252,6 +335,7 @@ static void dwt_encode97_int(DWTContext *s, int *t)
     int h = s->linelen[s->ndeclevels-1][1];
     int i;
     int *line = s->i_linebuf;
+    int *cols = s->i_linebuf + 5 * DWT_COLS;
     line += 5;
 
     for (i = 0; i < w * h; i++)
@@ -266,20 +350,23 @@ static void dwt_encode97_int(DWTContext *s, int *t)
         int *l;
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = cols + mv * DWT_COLS;
+        for (lp = 0; lp < lh; lp += DWT_COLS) {
+            int i, j = 0, c, n = FFMIN(DWT_COLS, lh - lp);
 
             for (i = 0; i < lv; i++)
-                l[i] = t[w*i + lp];
+                for (c = 0; c < n; c++)
+                    l[i * DWT_COLS + c] = t[w*i + lp + c];
 
-            sd_1d97_int(line, mv, mv + lv);
+            sd_1d97_int_cols(cols, mv, mv + lv, n);
 
             // copy back and deinterleave
             for (i =   mv; i < lv; i+=2, j++)
-                t[w*j + lp] = ((l[i] * I_LFTG_X) + (1 << 15)) >> 16;
+                for (c = 0; c < n; c++)
+                    t[w*j + lp + c] = ((l[i * DWT_COLS + c] * I_LFTG_X) + (1 << 15)) >> 16;
             for (i = 1-mv; i < lv; i+=2, j++)
-                t[w*j + lp] = l[i];
+                for (c = 0; c < n; c++)
+                    t[w*j + lp + c] = l[i * DWT_COLS + c];
         }
 
         // HOR_SD
@@ -563,12 +650,12 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
             return AVERROR(ENOMEM);
         break;
      case FF_DWT97_INT:
-        s->i_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->i_linebuf));
+        s->i_linebuf = av_malloc_array((maxlen + 12) * DWT_COLS, sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
             return AVERROR(ENOMEM);
         break;
     case FF_DWT53:
-        s->i_linebuf = av_malloc_array((maxlen +  6), sizeof(*s->i_linebuf));
+        s->i_linebuf = av_malloc_array((maxlen +  6) * DWT_COLS, sizeof(*s->i_linebuf));
         if (!s->i_linebuf)
             return AVERROR(ENOMEM);
         break;
@@ -776,10 +776,11 @@ int ff_mjpeg_decode_sof(MJpegDecodeContext *s)
     return 0;
 }
 
-static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
+static inline int mjpeg_decode_dc(MJpegDecodeContext *s, GetBitContext *gb,
+                                  int dc_index)
 {
     int code;
-    code = get_vlc2(&s->gb, s->vlcs[0][dc_index].table, 9, 2);
+    code = get_vlc2(gb, s->vlcs[0][dc_index].table, 9, 2);
     if (code < 0 || code > 16) {
         av_log(s->avctx, AV_LOG_WARNING,
                "mjpeg_decode_dc: bad vlc: %d:%d (%p)\n",
@@ -788,47 +789,48 @@ static inline int mjpeg_decode_dc(MJpegDecodeContext *s, int dc_index)
     }
 
     if (code)
-        return get_xbits(&s->gb, code);
+        return get_xbits(gb, code);
     else
         return 0;
 }
 
 /* decode block and dequantize */
-static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
+static int decode_block(MJpegDecodeContext *s, GetBitContext *gb,
+                        int *last_dc, int16_t *block, int component,
                         int dc_index, int ac_index, uint16_t *quant_matrix)
 {
     int code, i, j, level, val;
 
     /* DC coef */
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
     }
-    val = val * (unsigned)quant_matrix[0] + s->last_dc[component];
+    val = val * (unsigned)quant_matrix[0] + last_dc[component];
     val = av_clip_int16(val);
-    s->last_dc[component] = val;
+    last_dc[component] = val;
     block[0] = val;
     /* AC coefs */
     i = 0;
-    {OPEN_READER(re, &s->gb);
+    {OPEN_READER(re, gb);
     do {
-        UPDATE_CACHE(re, &s->gb);
-        GET_VLC(code, re, &s->gb, s->vlcs[1][ac_index].table, 9, 2);
+        UPDATE_CACHE(re, gb);
+        GET_VLC(code, re, gb, s->vlcs[1][ac_index].table, 9, 2);
 
         i += ((unsigned)code) >> 4;
             code &= 0xf;
         if (code) {
             if (code > MIN_CACHE_BITS - 16)
-                UPDATE_CACHE(re, &s->gb);
+                UPDATE_CACHE(re, gb);
 
             {
-                int cache = GET_CACHE(re, &s->gb);
+                int cache = GET_CACHE(re, gb);
                 int sign  = (~cache) >> 31;
                 level     = (NEG_USR32(sign ^ cache,code) ^ sign) - sign;
             }
 
-            LAST_SKIP_BITS(re, &s->gb, code);
+            LAST_SKIP_BITS(re, gb, code);
 
             if (i > 63) {
                 av_log(s->avctx, AV_LOG_ERROR, "error count: %d\n", i);
@@ -838,7 +840,7 @@ static int decode_block(MJpegDecodeContext *s, int16_t *block, int component,
             block[j] = level * quant_matrix[i];
         }
     } while (i < 63);
-    CLOSE_READER(re, &s->gb);}
+    CLOSE_READER(re, gb);}
 
     return 0;
 }
@@ -849,7 +851,7 @@ static int decode_dc_progressive(MJpegDecodeContext *s, int16_t *block,
 {
     unsigned val;
     s->bdsp.clear_block(block);
-    val = mjpeg_decode_dc(s, dc_index);
+    val = mjpeg_decode_dc(s, &s->gb, dc_index);
     if (val == 0xfffff) {
         av_log(s->avctx, AV_LOG_ERROR, "error dc\n");
         return AVERROR_INVALIDDATA;
@@ -1139,7 +1141,7 @@ static int ljpeg_decode_rgb_scan(MJpegDecodeContext *s, int nb_components, int p
                 topleft[i] = top[i];
                 top[i]     = buffer[mb_x][i];
 
-                dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                 if(dc == 0xFFFFF)
                     return -1;
 
@@ -1271,7 +1273,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for(j=0; j<n; j++) {
                         int pred, dc;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1342,7 +1344,7 @@ static int ljpeg_decode_yuv_scan(MJpegDecodeContext *s, int predictor,
                     for (j = 0; j < n; j++) {
                         int pred;
 
-                        dc = mjpeg_decode_dc(s, s->dc_index[i]);
+                        dc = mjpeg_decode_dc(s, &s->gb, s->dc_index[i]);
                         if(dc == 0xFFFFF)
                             return -1;
                         if (   h * mb_x + x >= s->width
@@ -1411,6 +1413,133 @@ static void shift_output(MJpegDecodeContext *s, uint8_t *ptr, int linesize)
     }
 }
 
+typedef struct MJpegScanThreadArg {
+    int nb_components;
+    int nb_segments;
+    int nb_jobs;
+    int nb_mcus;
+    int start;
+    int chroma_width, chroma_height;
+    int bytes_per_pixel;
+    uint8_t *data[MAX_COMPONENTS];
+    int linesize[MAX_COMPONENTS];
+} MJpegScanThreadArg;
+
+#define MAX_SCAN_JOBS 256
+
+/* Decode a run of restart intervals of a sequential DCT scan. Each interval
+ * starts byte aligned with reset DC predictors, so it only depends on its
+ * own slice of the unescaped scan buffer. */
+static int mjpeg_decode_scan_intervals(AVCodecContext *avctx, void *arg,
+                                       int jobnr, int threadnr)
+{
+    MJpegDecodeContext *s = avctx->priv_data;
+    const MJpegScanThreadArg *t = arg;
+    const uint8_t *buf = s->gb.buffer;
+    const int buf_size = s->gb.size_in_bits >> 3;
+    const int seg_start = jobnr      * t->nb_segments / t->nb_jobs;
+    const int seg_end   = (jobnr + 1) * t->nb_segments / t->nb_jobs;
+    LOCAL_ALIGNED_32(int16_t, block, [64]);
+    int seg, ret = 0;
+
+    for (seg = seg_start; seg < seg_end; seg++) {
+        GetBitContext gb;
+        int last_dc[MAX_COMPONENTS];
+        int start = seg ? s->restart_offsets[seg - 1] : t->start;
+        int end   = seg + 1 < t->nb_segments ? s->restart_offsets[seg] - 2 : buf_size;
+        int mcu   = seg * s->restart_interval;
+        int mcu_end = FFMIN(t->nb_mcus, mcu + s->restart_interval);
+        int i;
+
+        init_get_bits8(&gb, buf + start, end - start);
+        for (i = 0; i < t->nb_components; i++)
+            last_dc[i] = (4 << s->bits);
+
+        for (; mcu < mcu_end; mcu++) {
+            const int mb_x = mcu % s->mb_width;
+            const int mb_y = mcu / s->mb_width;
+
+            if (get_bits_left(&gb) < 0) {
+                av_log(avctx, AV_LOG_ERROR, "overread %d\n", -get_bits_left(&gb));
+                ret = AVERROR_INVALIDDATA;
+                break;
+            }
+            for (i = 0; i < t->nb_components; i++) {
+                int n, h, v, x, y, c, j;
+                int block_offset;
+                n = s->nb_blocks[i];
+                c = s->comp_index[i];
+                h = s->h_scount[i];
+                v = s->v_scount[i];
+                x = 0;
+                y = 0;
+                for (j = 0; j < n; j++) {
+                    block_offset = (((t->linesize[c] * (v * mb_y + y) * 8) +
+                                     (h * mb_x + x) * 8 * t->bytes_per_pixel) >> avctx->lowres);
+
+                    s->bdsp.clear_block(block);
+                    if (decode_block(s, &gb, last_dc, block, i,
+                                     s->dc_index[i], s->ac_index[i],
+                                     s->quant_matrixes[s->quant_sindex[i]]) < 0) {
+                        av_log(avctx, AV_LOG_ERROR,
+                               "error y=%d x=%d\n", mb_y, mb_x);
+                        ret = AVERROR_INVALIDDATA;
+                        goto next_segment;
+                    }
+                    if (   8*(h * mb_x + x) < ((c == 1) || (c == 2) ? t->chroma_width  : s->width)
+                        && 8*(v * mb_y + y) < ((c == 1) || (c == 2) ? t->chroma_height : s->height)) {
+                        uint8_t *ptr = t->data[c] + block_offset;
+                        s->idsp.idct_put(ptr, t->linesize[c], block);
+                        if (s->bits & 7)
+                            shift_output(s, ptr, t->linesize[c]);
+                    }
+                    if (++x == h) {
+                        x = 0;
+                        y++;
+                    }
+                }
+            }
+        }
+next_segment:;
+    }
+    return ret;
+}
+
+/* Split the scan at its RSTn markers and decode the restart intervals in
+ * parallel. Returns 1 if the scan cannot be split, so the caller falls back
+ * to decoding it sequentially. */
+static int mjpeg_decode_scan_threaded(MJpegDecodeContext *s, MJpegScanThreadArg *t)
+{
+    AVCodecContext *avctx = s->avctx;
+    int ret[MAX_SCAN_JOBS];
+    int i, prev;
+
+    t->nb_mcus     = s->mb_width * s->mb_height;
+    t->nb_segments = (t->nb_mcus + s->restart_interval - 1) / s->restart_interval;
+    t->start       = get_bits_count(&s->gb) >> 3;
+
+    if (t->nb_segments < 2 || s->nb_restart_offsets < t->nb_segments - 1 ||
+        get_bits_count(&s->gb) & 7)
+        return 1;
+
+    prev = t->start;
+    for (i = 0; i < t->nb_segments - 1; i++) {
+        if (s->restart_offsets[i] - 2 < prev)
+            return 1;
+        prev = s->restart_offsets[i];
+    }
+
+    t->nb_jobs = FFMIN3(t->nb_segments, 4 * avctx->thread_count, MAX_SCAN_JOBS);
+    avctx->execute2(avctx, mjpeg_decode_scan_intervals, t, ret, t->nb_jobs);
+
+    skip_bits_long(&s->gb, get_bits_left(&s->gb));
+
+    for (i = 0; i < t->nb_jobs; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
+
 static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
                              int Al, const uint8_t *mb_bitmask,
                              int mb_bitmask_size,
@@ -1446,6 +1575,24 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
         s->coefs_finished[c] |= 1;
     }
 
+    if ((s->avctx->active_thread_type & FF_THREAD_SLICE) &&
+        s->restart_interval && !s->progressive && !s->interlaced &&
+        !mb_bitmask && s->avctx->codec_id != AV_CODEC_ID_THP) {
+        MJpegScanThreadArg t = {
+            .nb_components   = nb_components,
+            .chroma_width    = chroma_width,
+            .chroma_height   = chroma_height,
+            .bytes_per_pixel = bytes_per_pixel,
+        };
+        int ret;
+
+        memcpy(t.data,     data,     sizeof(data));
+        memcpy(t.linesize, linesize, sizeof(linesize));
+        ret = mjpeg_decode_scan_threaded(s, &t);
+        if (ret <= 0)
+            return ret;
+    }
+
     for (mb_y = 0; mb_y < s->mb_height; mb_y++) {
         for (mb_x = 0; mb_x < s->mb_width; mb_x++) {
             const int copy_mb = mb_bitmask && !get_bits1(&mb_bitmask_gb);
@@ -1487,7 +1634,7 @@ static int mjpeg_decode_scan(MJpegDecodeContext *s, int nb_components, int Ah,
 
                         } else {
                             s->bdsp.clear_block(s->block);
-                            if (decode_block(s, s->block, i,
+                            if (decode_block(s, &s->gb, s->last_dc, s->block, i,
                                              s->dc_index[i], s->ac_index[i],
                                              s->quant_matrixes[s->quant_sindex[i]]) < 0) {
                                 av_log(s->avctx, AV_LOG_ERROR,
@@ -2218,10 +2365,14 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
             }                                         \
         } while (0)
 
+        s->nb_restart_offsets = 0;
+
         if (s->avctx->codec_id == AV_CODEC_ID_THP) {
             ptr = buf_end;
             copy_data_segment(0);
         } else {
+            const int slice_threads = s->avctx->active_thread_type & FF_THREAD_SLICE;
+
             while (ptr < buf_end) {
                 uint8_t x = *(ptr++);
 
@@ -2246,6 +2397,18 @@ int ff_mjpeg_find_marker(MJpegDecodeContext *s,
                         copy_data_segment(1);
                         if (x)
                             break;
+                    } else if (slice_threads) {
+                        /* remember where each restart interval starts in the
+                         * unescaped buffer so they can be decoded in parallel */
+                        int *offsets = av_fast_realloc(s->restart_offsets,
+                                                       &s->restart_offsets_size,
+                                                       (s->nb_restart_offsets + 1) *
+                                                       sizeof(*s->restart_offsets));
+                        if (!offsets)
+                            return AVERROR(ENOMEM);
+                        s->restart_offsets = offsets;
+                        s->restart_offsets[s->nb_restart_offsets++] =
+                            (dst - s->buffer) + (ptr - src);
                     }
                 }
             }
@@ -2898,6 +3061,7 @@ av_cold int ff_mjpeg_decode_end(AVCodecContext *avctx)
     av_frame_free(&s->smv_frame);
 
     av_freep(&s->buffer);
+    av_freep(&s->restart_offsets);
     av_freep(&s->stereo3d);
     av_freep(&s->ljpeg_buffer);
     s->ljpeg_buffer_size = 0;
@@ -2954,7 +3118,7 @@ AVCodec ff_mjpeg_decoder = {
     .close          = ff_mjpeg_decode_end,
     .receive_frame  = ff_mjpeg_receive_frame,
     .flush          = decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_SLICE_THREADS,
     .max_lowres     = 3,
     .priv_class     = &mjpegdec_class,
     .profiles       = NULL_IF_CONFIG_SMALL(ff_mjpeg_profiles),
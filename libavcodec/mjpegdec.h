@@ -117,6 +117,9 @@ typedef struct MJpegDecodeContext {
 
     int restart_interval;
     int restart_count;
+    int *restart_offsets;               ///< unescaped offsets of the data following each RSTn of the current scan
+    unsigned int restart_offsets_size;
+    int nb_restart_offsets;
 
     int buggy_avid;
     int cs_itu601;
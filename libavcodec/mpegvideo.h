@@ -560,6 +560,8 @@ typedef struct MpegEncContext {
     int vbv_ignore_qmax;
 
     char *rc_eq;
+    uint8_t *rc_stats;  ///< binary first pass statistics, see AV_PKT_DATA_RC_STATS
+    int rc_stats_size;
 
     /* temp buffers for rate control */
     float *cplx_tab, *bits_tab;
@@ -651,6 +653,8 @@ FF_MPV_OPT_CMP_FUNC, \
           "bits2qp(bits), qp2bits(qp). Also the following constants are available: iTex pTex tex mv "                                                                           \
           "fCode iCount mcVar var isI isP isB avgQP qComp avgIITex avgPITex avgPPTex avgBPTex avgTex.",                                                                         \
                                                                     FF_MPV_OFFSET(rc_eq), AV_OPT_TYPE_STRING,                           .flags = FF_MPV_OPT_FLAGS },            \
+{"rc_stats", "binary first pass statistics for two-pass encoding, used instead of stats_in",                                                                                     \
+                                                                    FF_MPV_OFFSET(rc_stats), AV_OPT_TYPE_BINARY,                        .flags = FF_MPV_OPT_FLAGS },            \
 {"rc_init_cplx", "initial complexity for 1-pass encoding",          FF_MPV_OFFSET(rc_initial_cplx), AV_OPT_TYPE_FLOAT, {.dbl = 0 }, -FLT_MAX, FLT_MAX, FF_MPV_OPT_FLAGS},       \
 {"rc_buf_aggressivity", "currently useless",                        FF_MPV_OFFSET(rc_buffer_aggressivity), AV_OPT_TYPE_FLOAT, {.dbl = 1.0 }, -FLT_MAX, FLT_MAX, FF_MPV_OPT_FLAGS}, \
 {"border_mask", "increase the quantizer for macroblocks close to borders", FF_MPV_OFFSET(border_masking), AV_OPT_TYPE_FLOAT, {.dbl = 0 }, -FLT_MAX, FLT_MAX, FF_MPV_OPT_FLAGS},    \
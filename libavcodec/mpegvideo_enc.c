@@ -1386,24 +1386,125 @@ static int encode_frame(AVCodecContext *c, AVFrame *frame, AVPacket *pkt)
     return size;
 }
 
-static int estimate_best_b_count(MpegEncContext *s)
+typedef struct BCountTrial {
+    MpegEncContext *s;
+    int b_count;
+    int p_lambda, b_lambda, lambda2;
+    int64_t rd;
+} BCountTrial;
+
+/**
+ * Encode the downscaled frames with b_count B-frames between P-frames and
+ * compute the resulting rate-distortion cost.
+ * Trials only read the shared downscaled frames, so they can run in parallel.
+ */
+static int estimate_b_count_trial(AVCodecContext *avctx, void *arg)
 {
+    BCountTrial *t = arg;
+    MpegEncContext *s = t->s;
     const AVCodec *codec = avcodec_find_encoder(s->avctx->codec_id);
+    AVFrame *frames[MAX_B_FRAMES + 2] = { NULL };
+    AVCodecContext *c;
     AVPacket *pkt;
+    int i, out_size, ret;
+
+    c   = avcodec_alloc_context3(NULL);
+    pkt = av_packet_alloc();
+    if (!c || !pkt) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    /* the picture types and qualities differ between trials, so each of
+     * them gets its own references to the frames */
+    for (i = 0; i < s->max_b_frames + 2; i++) {
+        frames[i] = av_frame_alloc();
+        if (!frames[i]) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        ret = av_frame_ref(frames[i], s->tmp_frames[i]);
+        if (ret < 0)
+            goto fail;
+    }
+
+    c->width        = s->width  >> s->brd_scale;
+    c->height       = s->height >> s->brd_scale;
+    c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
+    c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
+    c->mb_decision  = s->avctx->mb_decision;
+    c->me_cmp       = s->avctx->me_cmp;
+    c->mb_cmp       = s->avctx->mb_cmp;
+    c->me_sub_cmp   = s->avctx->me_sub_cmp;
+    c->pix_fmt      = AV_PIX_FMT_YUV420P;
+    c->time_base    = s->avctx->time_base;
+    c->max_b_frames = s->max_b_frames;
+
+    ret = avcodec_open2(c, codec, NULL);
+    if (ret < 0)
+        goto fail;
+
+    frames[0]->pict_type = AV_PICTURE_TYPE_I;
+    frames[0]->quality   = 1 * FF_QP2LAMBDA;
+
+    out_size = encode_frame(c, frames[0], pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+
+    //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
+
+    t->rd = 0;
+    for (i = 0; i < s->max_b_frames + 1; i++) {
+        int is_p = i % (t->b_count + 1) == t->b_count || i == s->max_b_frames;
+
+        frames[i + 1]->pict_type = is_p ?
+                                   AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
+        frames[i + 1]->quality   = is_p ? t->p_lambda : t->b_lambda;
+
+        out_size = encode_frame(c, frames[i + 1], pkt);
+        if (out_size < 0) {
+            ret = out_size;
+            goto fail;
+        }
+
+        t->rd += (out_size * t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    }
+
+    /* get the delayed frames */
+    out_size = encode_frame(c, NULL, pkt);
+    if (out_size < 0) {
+        ret = out_size;
+        goto fail;
+    }
+    t->rd += (out_size * t->lambda2) >> (FF_LAMBDA_SHIFT - 3);
+
+    t->rd += c->error[0] + c->error[1] + c->error[2];
+    ret = 0;
+
+fail:
+    for (i = 0; i < s->max_b_frames + 2; i++)
+        av_frame_free(&frames[i]);
+    avcodec_free_context(&c);
+    av_packet_free(&pkt);
+
+    return ret;
+}
+
+static int estimate_best_b_count(MpegEncContext *s)
+{
+    BCountTrial trials[MAX_B_FRAMES + 1];
+    int trial_ret[MAX_B_FRAMES + 1];
     const int scale = s->brd_scale;
     int width  = s->width  >> scale;
     int height = s->height >> scale;
-    int i, j, out_size, p_lambda, b_lambda, lambda2;
+    int i, j, nb_trials, p_lambda, b_lambda, lambda2;
     int64_t best_rd  = INT64_MAX;
     int best_b_count = -1;
-    int ret = 0;
 
     av_assert0(scale >= 0 && scale <= 3);
 
-    pkt = av_packet_alloc();
-    if (!pkt)
-        return AVERROR(ENOMEM);
-
     //emms_c();
     //s->next_picture_ptr->quality;
     p_lambda = s->last_lambda_for[AV_PICTURE_TYPE_P];
@@ -1447,89 +1548,33 @@ static int estimate_best_b_count(MpegEncContext *s)
         }
     }
 
-    for (j = 0; j < s->max_b_frames + 1; j++) {
-        AVCodecContext *c;
-        int64_t rd = 0;
+    for (nb_trials = 0; nb_trials < s->max_b_frames + 1; nb_trials++) {
+        BCountTrial *t = &trials[nb_trials];
 
-        if (!s->input_picture[j])
+        if (!s->input_picture[nb_trials])
             break;
 
-        c = avcodec_alloc_context3(NULL);
-        if (!c) {
-            ret = AVERROR(ENOMEM);
-            goto fail;
-        }
-
-        c->width        = width;
-        c->height       = height;
-        c->flags        = AV_CODEC_FLAG_QSCALE | AV_CODEC_FLAG_PSNR;
-        c->flags       |= s->avctx->flags & AV_CODEC_FLAG_QPEL;
-        c->mb_decision  = s->avctx->mb_decision;
-        c->me_cmp       = s->avctx->me_cmp;
-        c->mb_cmp       = s->avctx->mb_cmp;
-        c->me_sub_cmp   = s->avctx->me_sub_cmp;
-        c->pix_fmt      = AV_PIX_FMT_YUV420P;
-        c->time_base    = s->avctx->time_base;
-        c->max_b_frames = s->max_b_frames;
-
-        ret = avcodec_open2(c, codec, NULL);
-        if (ret < 0)
-            goto fail;
-
-
-        s->tmp_frames[0]->pict_type = AV_PICTURE_TYPE_I;
-        s->tmp_frames[0]->quality   = 1 * FF_QP2LAMBDA;
-
-        out_size = encode_frame(c, s->tmp_frames[0], pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-
-        //rd += (out_size * lambda2) >> FF_LAMBDA_SHIFT;
-
-        for (i = 0; i < s->max_b_frames + 1; i++) {
-            int is_p = i % (j + 1) == j || i == s->max_b_frames;
-
-            s->tmp_frames[i + 1]->pict_type = is_p ?
-                                     AV_PICTURE_TYPE_P : AV_PICTURE_TYPE_B;
-            s->tmp_frames[i + 1]->quality   = is_p ? p_lambda : b_lambda;
-
-            out_size = encode_frame(c, s->tmp_frames[i + 1], pkt);
-            if (out_size < 0) {
-                ret = out_size;
-                goto fail;
-            }
-
-            rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
-        }
+        t->s        = s;
+        t->b_count  = nb_trials;
+        t->p_lambda = p_lambda;
+        t->b_lambda = b_lambda;
+        t->lambda2  = lambda2;
+    }
 
-        /* get the delayed frames */
-        out_size = encode_frame(c, NULL, pkt);
-        if (out_size < 0) {
-            ret = out_size;
-            goto fail;
-        }
-        rd += (out_size * lambda2) >> (FF_LAMBDA_SHIFT - 3);
+    /* the trial encodes are independent, run them on the slice threads */
+    s->avctx->execute(s->avctx, estimate_b_count_trial, trials, trial_ret,
+                      nb_trials, sizeof(*trials));
 
-        rd += c->error[0] + c->error[1] + c->error[2];
+    for (j = 0; j < nb_trials; j++) {
+        if (trial_ret[j] < 0)
+            return trial_ret[j];
 
-        if (rd < best_rd) {
-            best_rd = rd;
+        if (trials[j].rd < best_rd) {
+            best_rd = trials[j].rd;
             best_b_count = j;
         }
-
-fail:
-        avcodec_free_context(&c);
-        av_packet_unref(pkt);
-        if (ret < 0) {
-            best_b_count = ret;
-            break;
-        }
     }
 
-    av_packet_free(&pkt);
-
     return best_b_count;
 }
 
@@ -1971,8 +2016,14 @@ FF_ENABLE_DEPRECATION_WARNINGS
             av_assert0(avctx->rc_max_rate);
         }
 
-        if (avctx->flags & AV_CODEC_FLAG_PASS1)
-            ff_write_pass1_stats(s);
+        if (avctx->flags & AV_CODEC_FLAG_PASS1) {
+            if (avctx->export_side_data & AV_CODEC_EXPORT_DATA_RC_STATS) {
+                ret = ff_export_pass1_stats(s, pkt);
+                if (ret < 0)
+                    return ret;
+            } else
+                ff_write_pass1_stats(s);
+        }
 
         for (i = 0; i < 4; i++) {
             s->current_picture_ptr->encoding_error[i] = s->current_picture.encoding_error[i];
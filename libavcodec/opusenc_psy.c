@@ -379,6 +379,38 @@ static int bands_dist(OpusPsyContext *s, CeltFrame *f, float *total_dist)
     return 0;
 }
 
+/* The trials run on a private copy of the frame, so that they can be done
+ * in parallel and do not advance the frame's noise seed. */
+static CeltFrame *trial_frame(OpusPsyContext *s, int threadnr)
+{
+    CeltFrame *f = &s->trial_frames[threadnr];
+
+    memcpy(f, s->trial_src, sizeof(*f));
+    f->pvq = s->trial_pvq[threadnr];
+
+    return f;
+}
+
+static int dual_stereo_trial(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    OpusPsyContext *s = arg;
+    CeltFrame *f = trial_frame(s, threadnr);
+
+    f->dual_stereo = jobnr;
+
+    return bands_dist(s, f, &s->trial_dist[jobnr]);
+}
+
+static int intensity_trial(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    OpusPsyContext *s = arg;
+    CeltFrame *f = trial_frame(s, threadnr);
+
+    f->intensity_stereo = f->end_band - jobnr;
+
+    return bands_dist(s, f, &s->trial_dist[jobnr]);
+}
+
 static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 {
     float td1, td2;
@@ -387,9 +419,10 @@ static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
     if (s->avctx->channels < 2)
         return;
 
-    bands_dist(s, f, &td1);
-    f->dual_stereo = 1;
-    bands_dist(s, f, &td2);
+    s->trial_src = f;
+    s->avctx->execute2(s->avctx, dual_stereo_trial, s, NULL, 2);
+    td1 = s->trial_dist[0];
+    td2 = s->trial_dist[1];
 
     f->dual_stereo = td2 < td1;
     s->dual_stereo_used += td2 < td1;
@@ -398,16 +431,19 @@ static void celt_search_for_dual_stereo(OpusPsyContext *s, CeltFrame *f)
 static void celt_search_for_intensity(OpusPsyContext *s, CeltFrame *f)
 {
     int i, best_band = CELT_MAX_BANDS - 1;
-    float dist, best_dist = FLT_MAX;
+    float best_dist = FLT_MAX;
     /* TODO: fix, make some heuristic up here using the lambda value */
-    float end_band = 0;
+    int end_band = 0;
 
     if (s->avctx->channels < 2)
         return;
 
+    s->trial_src = f;
+    s->avctx->execute2(s->avctx, intensity_trial, s, NULL,
+                       f->end_band - end_band + 1);
+
     for (i = f->end_band; i >= end_band; i--) {
-        f->intensity_stereo = i;
-        bands_dist(s, f, &dist);
+        float dist = s->trial_dist[f->end_band - i];
         if (best_dist > dist) {
             best_dist = dist;
             best_band = i;
@@ -513,6 +549,15 @@ void ff_opus_psy_postencode_update(OpusPsyContext *s, CeltFrame *f, OpusRangeCod
     s->inflection_points_count = 0;
 }
 
+static av_cold void free_trial_contexts(OpusPsyContext *s)
+{
+    if (s->trial_pvq)
+        for (int i = 0; i < s->nb_trial_threads; i++)
+            ff_celt_pvq_uninit(&s->trial_pvq[i]);
+    av_freep(&s->trial_pvq);
+    av_freep(&s->trial_frames);
+}
+
 av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
                              struct FFBufQueue *bufqueue, OpusEncOptions *options)
 {
@@ -568,11 +613,25 @@ av_cold int ff_opus_psy_init(OpusPsyContext *s, AVCodecContext *avctx,
             goto fail;
     }
 
+    if (s->avctx->channels == 2) {
+        s->nb_trial_threads = FFMAX(avctx->thread_count, 1);
+        s->trial_frames = av_malloc_array(s->nb_trial_threads, sizeof(*s->trial_frames));
+        s->trial_pvq    = av_mallocz_array(s->nb_trial_threads, sizeof(*s->trial_pvq));
+        if (!s->trial_frames || !s->trial_pvq) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        for (i = 0; i < s->nb_trial_threads; i++)
+            if ((ret = ff_celt_pvq_init(&s->trial_pvq[i], 1)) < 0)
+                goto fail;
+    }
+
     return 0;
 
 fail:
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
+    free_trial_contexts(s);
 
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
@@ -596,6 +655,7 @@ av_cold int ff_opus_psy_end(OpusPsyContext *s)
 
     av_freep(&s->inflection_points);
     av_freep(&s->dsp);
+    free_trial_contexts(s);
 
     for (i = 0; i < CELT_BLOCK_NB; i++) {
         ff_mdct15_uninit(&s->mdct[i]);
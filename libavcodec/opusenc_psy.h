@@ -75,6 +75,13 @@ typedef struct OpusPsyContext {
 
     DECLARE_ALIGNED(32, float, scratch)[2048];
 
+    /* Stereo decision search, one trial frame and PVQ context per thread */
+    CeltFrame *trial_frames;
+    CeltPVQ **trial_pvq;
+    int nb_trial_threads;
+    const CeltFrame *trial_src;
+    float trial_dist[CELT_MAX_BANDS + 1];
+
     /* Stats */
     float rc_waste;
     float avg_is_band;
@@ -290,6 +290,34 @@ enum AVPacketSideDataType {
      */
     AV_PKT_DATA_S12M_TIMECODE,
 
+    /**
+     * First pass rate control statistics of the frame in the packet,
+     * exported by encoders using the shared two-pass rate control (on demand
+     * through the rc_stats flag set in the AVCodecContext export_side_data
+     * field, together with AV_CODEC_FLAG_PASS1).
+     * @code
+     * u32le display picture number
+     * u32le coded picture number
+     * u32le picture type (enum AVPictureType)
+     * u32le quality factor (lambda)
+     * u32le intra texture bits
+     * u32le inter texture bits
+     * u32le motion vector bits
+     * u32le miscellaneous bits
+     * u32le header bits
+     * u32le forward f_code
+     * u32le backward f_code
+     * u32le intra macroblock count
+     * u32le skipped macroblock count
+     * u32le macroblock count of the picture
+     * u64le motion compensated variance sum
+     * u64le variance sum
+     * @endcode
+     * The concatenated side data of all packets can be passed to the second
+     * pass through the encoder's rc_stats option, instead of stats_in.
+     */
+    AV_PKT_DATA_RC_STATS,
+
     /**
      * The number of side data types.
      * This is not part of the public API/ABI in the sense that it may
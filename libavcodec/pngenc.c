@@ -36,6 +36,8 @@
 #include <zlib.h>
 
 #define IOBUF_SIZE 4096
+#define DEFLATE_WINDOW_SIZE (1 << 15)
+#define MAX_DEFLATE_JOBS 1024
 
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
@@ -45,6 +47,13 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGDeflateBlock {
+    int offset;                  ///< offset of the block in the filtered image data
+    int size;                    ///< size of the uncompressed block
+    int out_size;                ///< size of the compressed block
+    uint32_t adler;              ///< Adler-32 checksum of the uncompressed block
+} PNGDeflateBlock;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -57,6 +66,20 @@ typedef struct PNGEncContext {
 
     z_stream zstream;
     uint8_t buf[IOBUF_SIZE];
+    int compression_level;
+
+    // independently compressed deflate blocks
+    int dblock_size;             ///< uncompressed size of the deflate blocks, 0 if disabled
+    z_stream *dstreams;          ///< raw deflate streams, one per slice thread
+    int nb_dstreams;
+    PNGDeflateBlock *dblocks;
+    unsigned int dblocks_size;
+    uint8_t *filter_buf;         ///< filtered rows of the whole image
+    unsigned int filter_buf_size;
+    uint8_t *dblock_buf;         ///< compressed blocks, dblock_stride bytes apart
+    unsigned int dblock_buf_size;
+    int dblock_stride;
+
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -428,6 +451,126 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int deflate_block(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s   = avctx->priv_data;
+    z_stream *zstream  = &s->dstreams[threadnr];
+    PNGDeflateBlock *b = &s->dblocks[jobnr];
+    const uint8_t *src = s->filter_buf + b->offset;
+    const int last     = jobnr == *(int *)arg - 1;
+    int ret;
+
+    /* prime the window with the end of the previous block, as a single
+     * stream would have seen it, to keep the compression ratio */
+    if (b->offset) {
+        int dict_size = FFMIN(b->offset, DEFLATE_WINDOW_SIZE);
+        if (deflateSetDictionary(zstream, src - dict_size, dict_size) != Z_OK)
+            return AVERROR_EXTERNAL;
+    }
+
+    zstream->next_in   = src;
+    zstream->avail_in  = b->size;
+    zstream->next_out  = s->dblock_buf + 2 + jobnr * s->dblock_stride;
+    zstream->avail_out = s->dblock_stride;
+    ret = deflate(zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (last ? Z_STREAM_END : Z_OK) || zstream->avail_in)
+        ret = AVERROR_EXTERNAL;
+    else
+        ret = 0;
+    b->out_size = s->dblock_stride - zstream->avail_out;
+    b->adler    = adler32(adler32(0, NULL, 0), src, b->size);
+    deflateReset(zstream);
+
+    return ret;
+}
+
+/* Filter the whole image, then compress it in blocks of at least
+ * dblock_size bytes on the slice threads. The blocks are raw deflate
+ * streams terminated by a sync flush, so concatenated behind a zlib
+ * header they form a single standard zlib stream. */
+static int encode_frame_blocks(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    const int row_size  = (pict->width * s->bits_per_pixel + 7) >> 3;
+    const int filt_size = row_size + 1;
+    int rows_per_block  = FFMAX(1, (s->dblock_size + filt_size - 1) / filt_size);
+    int nb_blocks       = (pict->height + rows_per_block - 1) / rows_per_block;
+    int i, y, header, flevel, total_size, ret[MAX_DEFLATE_JOBS];
+    uint8_t *crow_base, *crow_buf, *top = NULL, *dst;
+    uLong adler;
+
+    if ((int64_t)filt_size * pict->height > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE)
+        return AVERROR(ENOMEM);
+    total_size = filt_size * pict->height;
+
+    if (nb_blocks > MAX_DEFLATE_JOBS) {
+        rows_per_block = (pict->height + MAX_DEFLATE_JOBS - 1) / MAX_DEFLATE_JOBS;
+        nb_blocks      = (pict->height + rows_per_block - 1) / rows_per_block;
+    }
+
+    av_fast_malloc(&s->filter_buf, &s->filter_buf_size, total_size);
+    av_fast_malloc(&s->dblocks, &s->dblocks_size, nb_blocks * sizeof(*s->dblocks));
+    if (!s->filter_buf || !s->dblocks)
+        return AVERROR(ENOMEM);
+
+    s->dblock_stride = deflateBound(&s->dstreams[0], rows_per_block * filt_size) + 16;
+    if ((int64_t)s->dblock_stride * nb_blocks > INT_MAX - 6)
+        return AVERROR(ENOMEM);
+    av_fast_malloc(&s->dblock_buf, &s->dblock_buf_size, s->dblock_stride * nb_blocks + 6);
+    if (!s->dblock_buf)
+        return AVERROR(ENOMEM);
+
+    crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    if (!crow_base)
+        return AVERROR(ENOMEM);
+    crow_buf = crow_base + 15;
+
+    for (y = 0; y < pict->height; y++) {
+        uint8_t *ptr  = pict->data[0] + y * pict->linesize[0];
+        uint8_t *crow = png_choose_filter(s, crow_buf, ptr, top,
+                                          row_size, s->bits_per_pixel >> 3);
+        memcpy(s->filter_buf + y * filt_size, crow, filt_size);
+        top = ptr;
+    }
+    av_freep(&crow_base);
+
+    for (i = 0; i < nb_blocks; i++) {
+        s->dblocks[i].offset = i * rows_per_block * filt_size;
+        s->dblocks[i].size   = FFMIN(rows_per_block * filt_size,
+                                     total_size - s->dblocks[i].offset);
+    }
+
+    avctx->execute2(avctx, deflate_block, &nb_blocks, ret, nb_blocks);
+
+    flevel = s->compression_level == Z_DEFAULT_COMPRESSION ? 2 :
+             s->compression_level < 2 ? 0 :
+             s->compression_level < 6 ? 1 :
+             s->compression_level == 6 ? 2 : 3;
+    header  = (0x78 << 8) | (flevel << 6);
+    header += 31 - header % 31;
+    AV_WB16(s->dblock_buf, header);
+
+    dst   = s->dblock_buf + 2;
+    adler = adler32(0, NULL, 0);
+    for (i = 0; i < nb_blocks; i++) {
+        const PNGDeflateBlock *b = &s->dblocks[i];
+        if (ret[i] < 0) {
+            av_log(avctx, AV_LOG_ERROR, "deflate error\n");
+            return ret[i];
+        }
+        memmove(dst, s->dblock_buf + 2 + i * s->dblock_stride, b->out_size);
+        dst  += b->out_size;
+        adler = adler32_combine(adler, b->adler, b->size);
+    }
+    bytestream_put_be32(&dst, adler);
+
+    if (s->bytestream_end - s->bytestream < dst - s->dblock_buf + 100)
+        return AVERROR(ENOMEM);
+    png_write_image_data(avctx, s->dblock_buf, dst - s->dblock_buf);
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -439,6 +582,9 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    if (s->dstreams && !s->is_progressive)
+        return encode_frame_blocks(avctx, pict);
+
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -1091,6 +1237,25 @@ FF_ENABLE_DEPRECATION_WARNINGS
                       : av_clip(avctx->compression_level, 0, 9);
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
+    s->compression_level = compression_level;
+
+    if (s->dblock_size) {
+        int i, nb_dstreams = avctx->active_thread_type & FF_THREAD_SLICE ?
+                             avctx->thread_count : 1;
+
+        s->dstreams = av_calloc(nb_dstreams, sizeof(*s->dstreams));
+        if (!s->dstreams)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < nb_dstreams; i++) {
+            s->dstreams[i].zalloc = ff_png_zalloc;
+            s->dstreams[i].zfree  = ff_png_zfree;
+            s->dstreams[i].opaque = NULL;
+            if (deflateInit2(&s->dstreams[i], compression_level, Z_DEFLATED,
+                             -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+                return -1;
+            s->nb_dstreams++;
+        }
+    }
 
     return 0;
 }
@@ -1098,8 +1263,15 @@ FF_ENABLE_DEPRECATION_WARNINGS
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
 
     deflateEnd(&s->zstream);
+    for (i = 0; i < s->nb_dstreams; i++)
+        deflateEnd(&s->dstreams[i]);
+    av_freep(&s->dstreams);
+    av_freep(&s->dblocks);
+    av_freep(&s->filter_buf);
+    av_freep(&s->dblock_buf);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1120,6 +1292,7 @@ static const AVOption options[] = {
         { "avg",   NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_AVG },   INT_MIN, INT_MAX, VE, "pred" },
         { "paeth", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_PAETH }, INT_MIN, INT_MAX, VE, "pred" },
         { "mixed", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_MIXED }, INT_MIN, INT_MAX, VE, "pred" },
+    { "dblock_size", "Compress the image in independent deflate blocks of this many bytes, in parallel with slice threads (0 disables)", OFFSET(dblock_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, VE },
     { NULL},
 };
 
@@ -1146,7 +1319,7 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -107,6 +107,12 @@ typedef struct PerThreadContext {
 
     int die;                        ///< Set when the thread should exit.
 
+    /**
+     * Set by ff_thread_flush() until the flush has been carried out on this
+     * thread, which happens once it is done with the packet it was decoding.
+     */
+    int flush_pending;
+
     int hwaccel_serializing;
     int async_serializing;
 
@@ -119,6 +125,11 @@ typedef struct PerThreadContext {
 typedef struct FrameThreadContext {
     PerThreadContext *threads;     ///< The contexts for each thread.
     PerThreadContext *prev_thread; ///< The last thread submit_packet() was called on.
+    /**
+     * The last thread submit_packet() was called on before a flush, whose
+     * state the first thread takes over when its own flush is carried out.
+     */
+    PerThreadContext *flush_src;
 
     pthread_mutex_t buffer_mutex;  ///< Mutex used to protect get/release_buffer().
     /**
@@ -396,6 +407,57 @@ static void release_delayed_buffers(PerThreadContext *p)
 }
 #endif
 
+static void await_setup_finished(PerThreadContext *p)
+{
+    if (atomic_load(&p->state) == STATE_SETTING_UP) {
+        pthread_mutex_lock(&p->progress_mutex);
+        while (atomic_load(&p->state) == STATE_SETTING_UP)
+            pthread_cond_wait(&p->progress_cond, &p->progress_mutex);
+        pthread_mutex_unlock(&p->progress_mutex);
+    }
+}
+
+/**
+ * Carry out a flush requested by ff_thread_flush() on a thread.
+ * Must be called with p->mutex held, i.e. while the thread is idle.
+ */
+static int finish_thread_flush(PerThreadContext *p)
+{
+    FrameThreadContext *fctx = p->parent;
+    const AVCodec *codec = p->avctx->codec;
+
+    if (!p->flush_pending)
+        return 0;
+
+    if (p == &fctx->threads[0] && fctx->flush_src) {
+        if (fctx->flush_src != p) {
+            int err;
+
+            await_setup_finished(fctx->flush_src);
+            err = update_context_from_thread(p->avctx, fctx->flush_src->avctx, 0);
+            if (err < 0)
+                return err;
+        }
+        fctx->flush_src = NULL;
+    }
+
+    // Make sure decode flush calls with size=0 won't return old frames
+    p->got_frame = 0;
+    av_frame_unref(p->frame);
+    p->result = 0;
+
+#if FF_API_THREAD_SAFE_CALLBACKS
+    release_delayed_buffers(p);
+#endif
+
+    if (codec->flush)
+        codec->flush(p->avctx);
+
+    p->flush_pending = 0;
+
+    return 0;
+}
+
 static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
                          AVPacket *avpkt)
 {
@@ -409,6 +471,12 @@ static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
 
     pthread_mutex_lock(&p->mutex);
 
+    ret = finish_thread_flush(p);
+    if (ret < 0) {
+        pthread_mutex_unlock(&p->mutex);
+        return ret;
+    }
+
     ret = update_context_from_user(p->avctx, user_avctx);
     if (ret) {
         pthread_mutex_unlock(&p->mutex);
@@ -424,12 +492,7 @@ static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
 
     if (prev_thread) {
         int err;
-        if (atomic_load(&prev_thread->state) == STATE_SETTING_UP) {
-            pthread_mutex_lock(&prev_thread->progress_mutex);
-            while (atomic_load(&prev_thread->state) == STATE_SETTING_UP)
-                pthread_cond_wait(&prev_thread->progress_cond, &prev_thread->progress_mutex);
-            pthread_mutex_unlock(&prev_thread->progress_mutex);
-        }
+        await_setup_finished(prev_thread);
 
         err = update_context_from_thread(p->avctx, prev_thread->avctx, 0);
         if (err) {
@@ -541,6 +604,16 @@ int ff_thread_decode_frame(AVCodecContext *avctx,
     do {
         p = &fctx->threads[finished++];
 
+        /* Threads not given a packet since a flush must not return
+         * anything decoded before it. */
+        if (p->flush_pending) {
+            pthread_mutex_lock(&p->mutex);
+            err = finish_thread_flush(p);
+            pthread_mutex_unlock(&p->mutex);
+            if (err < 0)
+                goto finish;
+        }
+
         if (atomic_load(&p->state) != STATE_INPUT_READY) {
             pthread_mutex_lock(&p->progress_mutex);
             while (atomic_load_explicit(&p->state, memory_order_relaxed) != STATE_INPUT_READY)
@@ -678,21 +751,24 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
 {
     FrameThreadContext *fctx = avctx->internal->thread_ctx;
     const AVCodec *codec = avctx->codec;
+    PerThreadContext *last_thread;
     int i;
 
     park_frame_worker_threads(fctx, thread_count);
 
-    if (fctx->prev_thread && avctx->internal->hwaccel_priv_data !=
-                             fctx->prev_thread->avctx->internal->hwaccel_priv_data) {
-        if (update_context_from_thread(avctx, fctx->prev_thread->avctx, 1) < 0) {
+    last_thread = fctx->prev_thread ? fctx->prev_thread : fctx->flush_src;
+
+    if (last_thread && avctx->internal->hwaccel_priv_data !=
+                       last_thread->avctx->internal->hwaccel_priv_data) {
+        if (update_context_from_thread(avctx, last_thread->avctx, 1) < 0) {
             av_log(avctx, AV_LOG_ERROR, "Failed to update user thread.\n");
         }
     }
 
-    if (fctx->prev_thread && fctx->prev_thread != fctx->threads)
-        if (update_context_from_thread(fctx->threads->avctx, fctx->prev_thread->avctx, 0) < 0) {
+    if (last_thread && last_thread != fctx->threads)
+        if (update_context_from_thread(fctx->threads->avctx, last_thread->avctx, 0) < 0) {
             av_log(avctx, AV_LOG_ERROR, "Final thread update failed\n");
-            fctx->prev_thread->avctx->internal->is_copy = fctx->threads->avctx->internal->is_copy;
+            last_thread->avctx->internal->is_copy = fctx->threads->avctx->internal->is_copy;
             fctx->threads->avctx->internal->is_copy = 1;
         }
 
@@ -901,28 +977,33 @@ void ff_thread_flush(AVCodecContext *avctx)
     if (!fctx) return;
 
     park_frame_worker_threads(fctx, avctx->thread_count);
-    if (fctx->prev_thread) {
-        if (fctx->prev_thread != &fctx->threads[0])
-            update_context_from_thread(fctx->threads[0].avctx, fctx->prev_thread->avctx, 0);
-    }
+    if (fctx->prev_thread)
+        fctx->flush_src = fctx->prev_thread;
 
     fctx->next_decoding = fctx->next_finished = 0;
     fctx->delaying = 1;
     fctx->prev_thread = NULL;
     for (i = 0; i < avctx->thread_count; i++) {
         PerThreadContext *p = &fctx->threads[i];
-        // Make sure decode flush calls with size=0 won't return old frames
-        p->got_frame = 0;
+
+        p->flush_pending = 1;
         av_frame_unref(p->frame);
-        p->result = 0;
+    }
 
+    /* The codec flush of each thread context is done when the thread is
+     * next given a packet. Main-thread callbacks and hwaccels need it done
+     * before returning, so flush them right away. */
+FF_DISABLE_DEPRECATION_WARNINGS
+    if (!avctx->hwaccel
 #if FF_API_THREAD_SAFE_CALLBACKS
-        release_delayed_buffers(p);
+        && THREAD_SAFE_CALLBACKS(avctx)
 #endif
+        )
+        return;
+FF_ENABLE_DEPRECATION_WARNINGS
 
-        if (avctx->codec->flush)
-            avctx->codec->flush(p->avctx);
-    }
+    for (i = 0; i < avctx->thread_count; i++)
+        finish_thread_flush(&fctx->threads[i]);
 }
 
 int ff_thread_can_start_frame(AVCodecContext *avctx)
@@ -35,34 +35,86 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "libavutil/imgutils.h"
+
 #include "avcodec.h"
 #include "decode.h"
 #include "bytestream.h"
 #include "internal.h"
+#include "thread.h"
 
 typedef struct QtrleContext {
     AVCodecContext *avctx;
-    AVFrame *frame;
+    ThreadFrame frame;
+    ThreadFrame prev;   ///< reference picture when frame threading
+
+    /**
+     * Rows at the top of frame which hold the reference picture or newly
+     * decoded data; with frame threading the others are copied from prev
+     * on demand, as soon as the decoder is about to write to them.
+     */
+    int rows_synced;
+    /**
+     * Lowest offset the decoder may still write to. Decoding can only step
+     * back into the row above the current one, so everything above that is
+     * final and can be reported to the next frame thread.
+     */
+    int pixel_floor;
 
     GetByteContext g;
     uint32_t pal[256];
 } QtrleContext;
 
+/**
+ * Make sure the first rows rows of the current frame contain the reference
+ * picture before they are written to.
+ */
+static void qtrle_sync_rows(QtrleContext *s, int rows)
+{
+    AVFrame *dst = s->frame.f, *src = s->prev.f;
+
+    rows = FFMIN(rows, s->avctx->height);
+    if (rows <= s->rows_synced)
+        return;
+
+    if (src->data[0]) {
+        ff_thread_await_progress(&s->prev, rows - 1, 0);
+        av_image_copy_plane(dst->data[0] + s->rows_synced * dst->linesize[0],
+                            dst->linesize[0],
+                            src->data[0] + s->rows_synced * src->linesize[0],
+                            src->linesize[0],
+                            FFMIN(dst->linesize[0], src->linesize[0]),
+                            rows - s->rows_synced);
+    }
+    s->rows_synced = rows;
+}
+
+static void qtrle_start_row(QtrleContext *s, int row_ptr)
+{
+    int row = row_ptr / s->frame.f->linesize[0];
+
+    s->pixel_floor = FFMAX(row - 1, 0) * s->frame.f->linesize[0];
+    qtrle_sync_rows(s, row + 1);
+    if (row >= 2)
+        ff_thread_report_progress(&s->frame, row - 2, 0);
+}
+
 #define CHECK_PIXEL_PTR(n)                                                            \
-    if ((pixel_ptr + n > pixel_limit) || (pixel_ptr + n < 0)) {                       \
+    if ((pixel_ptr + n > pixel_limit) || (pixel_ptr < s->pixel_floor)) {              \
         av_log (s->avctx, AV_LOG_ERROR, "Problem: pixel_ptr = %d, pixel_limit = %d\n",\
                 pixel_ptr + n, pixel_limit);                                          \
         return;                                                                       \
     }                                                                                 \
+    qtrle_sync_rows(s, (pixel_ptr + n) / row_inc + 1);                                \
 
 static void qtrle_decode_1bpp(QtrleContext *s, int row_ptr, int lines_to_change)
 {
     int rle_code;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     uint8_t pi0, pi1;  /* 2 8-pixel values */
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
     int skip;
     /* skip & 0x80 appears to mean 'start a new line', which can be interpreted
      * as 'go to next line' during the decoding of a frame but is 'go to first
@@ -84,6 +136,7 @@ static void qtrle_decode_1bpp(QtrleContext *s, int row_ptr, int lines_to_change)
         if(skip & 0x80) {
             lines_to_change--;
             row_ptr += row_inc;
+            qtrle_start_row(s, row_ptr);
             pixel_ptr = row_ptr + 2 * 8 * (skip & 0x7f);
         } else
             pixel_ptr += 2 * 8 * skip;
@@ -145,13 +198,14 @@ static inline void qtrle_decode_2n4bpp(QtrleContext *s, int row_ptr,
 {
     int rle_code, i;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     uint8_t pi[16];  /* 16 palette indices */
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
     int num_pixels = (bpp == 4) ? 8 : 16;
 
     while (lines_to_change--) {
+        qtrle_start_row(s, row_ptr);
         pixel_ptr = row_ptr + (num_pixels * (bytestream2_get_byte(&s->g) - 1));
         CHECK_PIXEL_PTR(0);
 
@@ -203,12 +257,13 @@ static void qtrle_decode_8bpp(QtrleContext *s, int row_ptr, int lines_to_change)
 {
     int rle_code;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     uint8_t pi1, pi2, pi3, pi4;  /* 4 palette indexes */
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
 
     while (lines_to_change--) {
+        qtrle_start_row(s, row_ptr);
         pixel_ptr = row_ptr + (4 * (bytestream2_get_byte(&s->g) - 1));
         CHECK_PIXEL_PTR(0);
 
@@ -254,12 +309,13 @@ static void qtrle_decode_16bpp(QtrleContext *s, int row_ptr, int lines_to_change
 {
     int rle_code;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     uint16_t rgb16;
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
 
     while (lines_to_change--) {
+        qtrle_start_row(s, row_ptr);
         pixel_ptr = row_ptr + (bytestream2_get_byte(&s->g) - 1) * 2;
         CHECK_PIXEL_PTR(0);
 
@@ -300,13 +356,14 @@ static void qtrle_decode_24bpp(QtrleContext *s, int row_ptr, int lines_to_change
 {
     int rle_code, rle_code_half;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     uint8_t b;
     uint16_t rg;
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
 
     while (lines_to_change--) {
+        qtrle_start_row(s, row_ptr);
         pixel_ptr = row_ptr + (bytestream2_get_byte(&s->g) - 1) * 3;
         CHECK_PIXEL_PTR(0);
 
@@ -356,12 +413,13 @@ static void qtrle_decode_32bpp(QtrleContext *s, int row_ptr, int lines_to_change
 {
     int rle_code, rle_code_half;
     int pixel_ptr;
-    int row_inc = s->frame->linesize[0];
+    int row_inc = s->frame.f->linesize[0];
     unsigned int argb;
-    uint8_t *rgb = s->frame->data[0];
-    int pixel_limit = s->frame->linesize[0] * s->avctx->height;
+    uint8_t *rgb = s->frame.f->data[0];
+    int pixel_limit = s->frame.f->linesize[0] * s->avctx->height;
 
     while (lines_to_change--) {
+        qtrle_start_row(s, row_ptr);
         pixel_ptr = row_ptr + (bytestream2_get_byte(&s->g) - 1) * 4;
         CHECK_PIXEL_PTR(0);
 
@@ -438,9 +496,13 @@ static av_cold int qtrle_decode_init(AVCodecContext *avctx)
         return AVERROR_INVALIDDATA;
     }
 
-    s->frame = av_frame_alloc();
-    if (!s->frame)
+    s->frame.f = av_frame_alloc();
+    s->prev.f  = av_frame_alloc();
+    if (!s->frame.f || !s->prev.f) {
+        av_frame_free(&s->frame.f);
+        av_frame_free(&s->prev.f);
         return AVERROR(ENOMEM);
+    }
 
     return 0;
 }
@@ -450,12 +512,21 @@ static int qtrle_decode_frame(AVCodecContext *avctx,
                               AVPacket *avpkt)
 {
     QtrleContext *s = avctx->priv_data;
+    int frame_threads = avctx->active_thread_type & FF_THREAD_FRAME;
     int header, start_line;
     int height, row_ptr;
-    int has_palette = 0;
     int duplicate = 0;
     int ret, size;
 
+    if (frame_threads) {
+        /* continue from the reference picture, like the single threaded
+         * decoder does with its one frame */
+        ff_thread_release_buffer(avctx, &s->frame);
+        if (s->prev.f->data[0] &&
+            (ret = ff_thread_ref_frame(&s->frame, &s->prev)) < 0)
+            return ret;
+    }
+
     bytestream2_init(&s->g, avpkt->data, avpkt->size);
 
     /* check if this frame is even supposed to change */
@@ -491,34 +562,48 @@ static int qtrle_decode_frame(AVCodecContext *avctx,
         start_line = 0;
         height     = s->avctx->height;
     }
-    if ((ret = ff_reget_buffer(avctx, s->frame, 0)) < 0)
-        return ret;
+    if (frame_threads) {
+        ff_thread_release_buffer(avctx, &s->frame);
+        if ((ret = ff_thread_get_buffer(avctx, &s->frame, AV_GET_BUFFER_FLAG_REF)) < 0)
+            return ret;
+        s->rows_synced = 0;
+    } else {
+        if ((ret = ff_reget_buffer(avctx, s->frame.f, 0)) < 0)
+            return ret;
+        s->rows_synced = avctx->height;
+    }
+
+    if (avctx->pix_fmt == AV_PIX_FMT_PAL8) {
+        s->frame.f->palette_has_changed = ff_copy_palette(s->pal, avpkt, avctx);
+
+        /* make the palette available on the way out */
+        memcpy(s->frame.f->data[1], s->pal, AVPALETTE_SIZE);
+    }
 
-    row_ptr = s->frame->linesize[0] * start_line;
+    ff_thread_finish_setup(avctx);
+
+    row_ptr        = s->frame.f->linesize[0] * start_line;
+    s->pixel_floor = s->frame.f->linesize[0] * FFMAX(start_line - 1, 0);
 
     switch (avctx->bits_per_coded_sample) {
     case 1:
     case 33:
         qtrle_decode_1bpp(s, row_ptr, height);
-        has_palette = 1;
         break;
 
     case 2:
     case 34:
         qtrle_decode_2n4bpp(s, row_ptr, height, 2);
-        has_palette = 1;
         break;
 
     case 4:
     case 36:
         qtrle_decode_2n4bpp(s, row_ptr, height, 4);
-        has_palette = 1;
         break;
 
     case 8:
     case 40:
         qtrle_decode_8bpp(s, row_ptr, height);
-        has_palette = 1;
         break;
 
     case 16:
@@ -539,25 +624,21 @@ static int qtrle_decode_frame(AVCodecContext *avctx,
         break;
     }
 
-    if(has_palette) {
-        s->frame->palette_has_changed = ff_copy_palette(s->pal, avpkt, avctx);
-
-        /* make the palette available on the way out */
-        memcpy(s->frame->data[1], s->pal, AVPALETTE_SIZE);
-    }
+    qtrle_sync_rows(s, avctx->height);
+    ff_thread_report_progress(&s->frame, INT_MAX, 0);
 
 done:
-    if (!s->frame->data[0])
+    if (!s->frame.f->data[0])
         return AVERROR_INVALIDDATA;
     if (duplicate) {
         // ff_reget_buffer() isn't needed when frames don't change, so just update
         // frame props.
-        ret = ff_decode_frame_props(avctx, s->frame);
+        ret = ff_decode_frame_props(avctx, s->frame.f);
         if (ret < 0)
             return ret;
     }
 
-    if ((ret = av_frame_ref(data, s->frame)) < 0)
+    if ((ret = av_frame_ref(data, s->frame.f)) < 0)
         return ret;
     *got_frame      = 1;
 
@@ -565,18 +646,42 @@ done:
     return avpkt->size;
 }
 
+#if HAVE_THREADS
+static int qtrle_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    QtrleContext *s = dst->priv_data, *s1 = src->priv_data;
+    int ret;
+
+    if (dst == src)
+        return 0;
+
+    ff_thread_release_buffer(dst, &s->prev);
+    if (s1->frame.f->data[0] &&
+        (ret = ff_thread_ref_frame(&s->prev, &s1->frame)) < 0)
+        return ret;
+
+    memcpy(s->pal, s1->pal, sizeof(s->pal));
+
+    return 0;
+}
+#endif
+
 static void qtrle_decode_flush(AVCodecContext *avctx)
 {
     QtrleContext *s = avctx->priv_data;
 
-    av_frame_unref(s->frame);
+    ff_thread_release_buffer(avctx, &s->frame);
+    ff_thread_release_buffer(avctx, &s->prev);
 }
 
 static av_cold int qtrle_decode_end(AVCodecContext *avctx)
 {
     QtrleContext *s = avctx->priv_data;
 
-    av_frame_free(&s->frame);
+    ff_thread_release_buffer(avctx, &s->frame);
+    av_frame_free(&s->frame.f);
+    ff_thread_release_buffer(avctx, &s->prev);
+    av_frame_free(&s->prev.f);
 
     return 0;
 }
@@ -591,5 +696,7 @@ AVCodec ff_qtrle_decoder = {
     .close          = qtrle_decode_end,
     .decode         = qtrle_decode_frame,
     .flush          = qtrle_decode_flush,
-    .capabilities   = AV_CODEC_CAP_DR1,
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(qtrle_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_ALLOCATE_PROGRESS,
 };
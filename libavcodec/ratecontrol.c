@@ -29,6 +29,7 @@
 #include "libavutil/internal.h"
 
 #include "avcodec.h"
+#include "bytestream.h"
 #include "internal.h"
 #include "ratecontrol.h"
 #include "mpegutils.h"
@@ -56,6 +57,104 @@ void ff_write_pass1_stats(MpegEncContext *s)
              s->header_bits);
 }
 
+/* size of an AV_PKT_DATA_RC_STATS record */
+#define RC_STATS_SIZE (14 * 4 + 2 * 8)
+
+int ff_export_pass1_stats(MpegEncContext *s, AVPacket *pkt)
+{
+    uint8_t *p = av_packet_new_side_data(pkt, AV_PKT_DATA_RC_STATS, RC_STATS_SIZE);
+
+    if (!p)
+        return AVERROR(ENOMEM);
+
+    bytestream_put_le32(&p, s->current_picture_ptr->f->display_picture_number);
+    bytestream_put_le32(&p, s->current_picture_ptr->f->coded_picture_number);
+    bytestream_put_le32(&p, s->pict_type);
+    bytestream_put_le32(&p, s->current_picture.f->quality);
+    bytestream_put_le32(&p, s->i_tex_bits);
+    bytestream_put_le32(&p, s->p_tex_bits);
+    bytestream_put_le32(&p, s->mv_bits);
+    bytestream_put_le32(&p, s->misc_bits);
+    bytestream_put_le32(&p, s->header_bits);
+    bytestream_put_le32(&p, s->f_code);
+    bytestream_put_le32(&p, s->b_code);
+    bytestream_put_le32(&p, s->i_count);
+    bytestream_put_le32(&p, s->skip_count);
+    bytestream_put_le32(&p, s->mb_num);
+    bytestream_put_le64(&p, s->current_picture.mc_mb_var_sum);
+    bytestream_put_le64(&p, s->current_picture.mb_var_sum);
+
+    return 0;
+}
+
+static int read_stats_binary(MpegEncContext *s)
+{
+    RateControlContext *rcc = &s->rc_context;
+    GetByteContext gb;
+    int i;
+
+    bytestream2_init(&gb, s->rc_stats, s->rc_stats_size);
+
+    for (i = 0; i < rcc->num_entries - s->max_b_frames; i++) {
+        RateControlEntry *rce;
+        unsigned picture_number, mb_num;
+
+        picture_number = bytestream2_get_le32(&gb);
+        if (picture_number >= rcc->num_entries) {
+            av_log(s->avctx, AV_LOG_ERROR,
+                   "statistics are damaged at entry %d\n", i);
+            return AVERROR_INVALIDDATA;
+        }
+        rce = &rcc->entry[picture_number];
+
+        bytestream2_skip(&gb, 4); // coded picture number
+        rce->pict_type     = bytestream2_get_le32(&gb);
+        rce->qscale        = bytestream2_get_le32(&gb);
+        rce->i_tex_bits    = bytestream2_get_le32(&gb);
+        rce->p_tex_bits    = bytestream2_get_le32(&gb);
+        rce->mv_bits       = bytestream2_get_le32(&gb);
+        rce->misc_bits     = bytestream2_get_le32(&gb);
+        rce->header_bits   = bytestream2_get_le32(&gb);
+        rce->f_code        = bytestream2_get_le32(&gb);
+        rce->b_code        = bytestream2_get_le32(&gb);
+        rce->i_count       = bytestream2_get_le32(&gb);
+        rce->skip_count    = bytestream2_get_le32(&gb);
+        mb_num             = bytestream2_get_le32(&gb);
+        rce->mc_mb_var_sum = bytestream2_get_le64(&gb);
+        rce->mb_var_sum    = bytestream2_get_le64(&gb);
+
+        if (rce->pict_type < AV_PICTURE_TYPE_I || rce->pict_type > AV_PICTURE_TYPE_B ||
+            !mb_num || mb_num > INT_MAX / 256) {
+            av_log(s->avctx, AV_LOG_ERROR,
+                   "statistics are damaged at entry %d\n", i);
+            return AVERROR_INVALIDDATA;
+        }
+
+        /* The first pass may have run at a lower resolution; scale what
+         * grows with the picture area, and the motion vector range along
+         * with the picture width. */
+        if (mb_num != s->mb_num) {
+            double scale = s->mb_num / (double)mb_num;
+            int fcode_shift = lrint(log2(scale) / 2);
+
+            rce->i_tex_bits    = FFMIN(rce->i_tex_bits * scale, INT_MAX);
+            rce->p_tex_bits    = FFMIN(rce->p_tex_bits * scale, INT_MAX);
+            rce->mv_bits       = FFMIN(rce->mv_bits    * scale, INT_MAX);
+            rce->misc_bits     = FFMIN(rce->misc_bits  * scale, INT_MAX);
+            rce->i_count       = FFMIN(rce->i_count    * scale, s->mb_num);
+            rce->skip_count    = FFMIN(rce->skip_count * scale, s->mb_num);
+            rce->mc_mb_var_sum = rce->mc_mb_var_sum * scale;
+            rce->mb_var_sum    = rce->mb_var_sum    * scale;
+            if (rce->f_code > 0)
+                rce->f_code = av_clip(rce->f_code + fcode_shift, 1, MAX_FCODE);
+            if (rce->b_code > 0)
+                rce->b_code = av_clip(rce->b_code + fcode_shift, 1, MAX_FCODE);
+        }
+    }
+
+    return 0;
+}
+
 static double get_fps(AVCodecContext *avctx)
 {
     return 1.0 / av_q2d(avctx->time_base) / FFMAX(avctx->ticks_per_frame, 1);
@@ -546,9 +645,18 @@ av_cold int ff_rate_control_init(MpegEncContext *s)
         char *p;
 
         /* find number of pics */
-        p = s->avctx->stats_in;
-        for (i = -1; p; i++)
-            p = strchr(p + 1, ';');
+        if (s->rc_stats) {
+            if (s->rc_stats_size % RC_STATS_SIZE) {
+                av_log(s->avctx, AV_LOG_ERROR, "rc_stats size is not a multiple of %d\n",
+                       RC_STATS_SIZE);
+                return AVERROR_INVALIDDATA;
+            }
+            i = s->rc_stats_size / RC_STATS_SIZE;
+        } else {
+            p = s->avctx->stats_in;
+            for (i = -1; p; i++)
+                p = strchr(p + 1, ';');
+        }
         i += s->max_b_frames;
         if (i <= 0 || i >= INT_MAX / sizeof(RateControlEntry))
             return -1;
@@ -569,38 +677,44 @@ av_cold int ff_rate_control_init(MpegEncContext *s)
         }
 
         /* read stats */
-        p = s->avctx->stats_in;
-        for (i = 0; i < rcc->num_entries - s->max_b_frames; i++) {
-            RateControlEntry *rce;
-            int picture_number;
-            int e;
-            char *next;
-
-            next = strchr(p, ';');
-            if (next) {
-                (*next) = 0; // sscanf is unbelievably slow on looong strings // FIXME copy / do not write
-                next++;
-            }
-            e = sscanf(p, " in:%d ", &picture_number);
-
-            av_assert0(picture_number >= 0);
-            av_assert0(picture_number < rcc->num_entries);
-            rce = &rcc->entry[picture_number];
-
-            e += sscanf(p, " in:%*d out:%*d type:%d q:%f itex:%d ptex:%d mv:%d misc:%d fcode:%d bcode:%d mc-var:%"SCNd64" var:%"SCNd64" icount:%d skipcount:%d hbits:%d",
-                        &rce->pict_type, &rce->qscale, &rce->i_tex_bits, &rce->p_tex_bits,
-                        &rce->mv_bits, &rce->misc_bits,
-                        &rce->f_code, &rce->b_code,
-                        &rce->mc_mb_var_sum, &rce->mb_var_sum,
-                        &rce->i_count, &rce->skip_count, &rce->header_bits);
-            if (e != 14) {
-                av_log(s->avctx, AV_LOG_ERROR,
-                       "statistics are damaged at line %d, parser out=%d\n",
-                       i, e);
-                return -1;
-            }
+        if (s->rc_stats) {
+            int ret = read_stats_binary(s);
+            if (ret < 0)
+                return ret;
+        } else {
+            p = s->avctx->stats_in;
+            for (i = 0; i < rcc->num_entries - s->max_b_frames; i++) {
+                RateControlEntry *rce;
+                int picture_number;
+                int e;
+                char *next;
+
+                next = strchr(p, ';');
+                if (next) {
+                    (*next) = 0; // sscanf is unbelievably slow on looong strings // FIXME copy / do not write
+                    next++;
+                }
+                e = sscanf(p, " in:%d ", &picture_number);
+
+                av_assert0(picture_number >= 0);
+                av_assert0(picture_number < rcc->num_entries);
+                rce = &rcc->entry[picture_number];
+
+                e += sscanf(p, " in:%*d out:%*d type:%d q:%f itex:%d ptex:%d mv:%d misc:%d fcode:%d bcode:%d mc-var:%"SCNd64" var:%"SCNd64" icount:%d skipcount:%d hbits:%d",
+                            &rce->pict_type, &rce->qscale, &rce->i_tex_bits, &rce->p_tex_bits,
+                            &rce->mv_bits, &rce->misc_bits,
+                            &rce->f_code, &rce->b_code,
+                            &rce->mc_mb_var_sum, &rce->mb_var_sum,
+                            &rce->i_count, &rce->skip_count, &rce->header_bits);
+                if (e != 14) {
+                    av_log(s->avctx, AV_LOG_ERROR,
+                           "statistics are damaged at line %d, parser out=%d\n",
+                           i, e);
+                    return -1;
+                }
 
-            p = next;
+                p = next;
+            }
         }
 
         if (init_pass2(s) < 0) {
@@ -675,6 +789,7 @@ av_cold void ff_rate_control_uninit(MpegEncContext *s)
     emms_c();
 
     av_expr_free(rcc->rc_eq_eval);
+    rcc->rc_eq_eval = NULL;
     av_freep(&rcc->entry);
 }
 
@@ -87,11 +87,18 @@ typedef struct RateControlContext{
 }RateControlContext;
 
 struct MpegEncContext;
+struct AVPacket;
 
 /* rate control */
 int ff_rate_control_init(struct MpegEncContext *s);
 float ff_rate_estimate_qscale(struct MpegEncContext *s, int dry_run);
 void ff_write_pass1_stats(struct MpegEncContext *s);
+/**
+ * Attach the first pass statistics of the current picture to pkt as
+ * AV_PKT_DATA_RC_STATS side data, the binary counterpart of
+ * ff_write_pass1_stats().
+ */
+int ff_export_pass1_stats(struct MpegEncContext *s, struct AVPacket *pkt);
 void ff_rate_control_uninit(struct MpegEncContext *s);
 int ff_vbv_update(struct MpegEncContext *s, int frame_size);
 void ff_get_2pass_fcode(struct MpegEncContext *s);
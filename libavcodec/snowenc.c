@@ -1887,8 +1887,14 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if(s->pass1_rc)
         if (ff_rate_estimate_qscale(&s->m, 0) < 0)
             return -1;
-    if(avctx->flags&AV_CODEC_FLAG_PASS1)
-        ff_write_pass1_stats(&s->m);
+    if (avctx->flags & AV_CODEC_FLAG_PASS1) {
+        if (avctx->export_side_data & AV_CODEC_EXPORT_DATA_RC_STATS) {
+            ret = ff_export_pass1_stats(&s->m, pkt);
+            if (ret < 0)
+                return ret;
+        } else
+            ff_write_pass1_stats(&s->m);
+    }
     s->m.last_pict_type = s->m.pict_type;
 #if FF_API_STAT_BITS
 FF_DISABLE_DEPRECATION_WARNINGS
@@ -1953,6 +1959,8 @@ static const AVOption options[] = {
      "bits2qp(bits), qp2bits(qp). Also the following constants are available: iTex pTex tex mv "
      "fCode iCount mcVar var isI isP isB avgQP qComp avgIITex avgPITex avgPPTex avgBPTex avgTex.",
                                                                                   OFFSET(m.rc_eq), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, VE },
+    { "rc_stats", "binary first pass statistics for two-pass encoding, used instead of stats_in",
+                                                                                  OFFSET(m.rc_stats), AV_OPT_TYPE_BINARY, { .str = NULL }, 0, 0, VE },
     { NULL },
 };
 
@@ -0,0 +1,176 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/h2645_parse.h"
+#include "libavcodec/internal.h"
+
+#define MAX_SIZE 256
+
+static uint8_t src_buf[MAX_SIZE + 8 + AV_INPUT_BUFFER_PADDING_SIZE];
+static uint8_t ref_buf[MAX_SIZE];
+static int     ref_skipped[MAX_SIZE];
+
+/* Unescape one byte at a time: stop before a 00 00 01 or 00 00 02 start
+ * code, drop the 03 of every 00 00 03. Returns the number of bytes used. */
+static int ref_extract_rbsp(const uint8_t *src, int length,
+                            int *size, int *skipped)
+{
+    int si = 0, di = 0;
+
+    *skipped = 0;
+    while (si + 2 < length) {
+        if (!src[si] && !src[si + 1] && src[si + 2] == 3) {
+            ref_buf[di++] = 0;
+            ref_buf[di++] = 0;
+            si += 3;
+            ref_skipped[(*skipped)++] = di - 1;
+            continue;
+        }
+        if (!src[si] && !src[si + 1] && src[si + 2] && src[si + 2] < 3)
+            break;
+        ref_buf[di++] = src[si++];
+    }
+    if (si + 2 >= length)
+        while (si < length)
+            ref_buf[di++] = src[si++];
+
+    *size = di;
+    return si;
+}
+
+static int check(H2645RBSP *rbsp, H2645NAL *nal, const uint8_t *src,
+                 int length, const char *desc, int pos)
+{
+    int small_padding, ref_size, ref_skipped_bytes, ref_ret, ret;
+    int i, raw_pos = 0, zeros = 0;
+
+    ref_ret = ref_extract_rbsp(src, length, &ref_size, &ref_skipped_bytes);
+
+    // the byte reader does not stop at start codes, compare up to there
+    for (i = 0; i < ref_size; i++) {
+        ret = ff_h2645_get_raw_byte(src, length, &raw_pos, &zeros);
+        if (ret != ref_buf[i]) {
+            fprintf(stderr, "%s at %d, length %d: raw byte %d is %d, "
+                    "expected %d\n", desc, pos, length, i, ret, ref_buf[i]);
+            return 1;
+        }
+    }
+
+    for (small_padding = 0; small_padding < 2; small_padding++) {
+        rbsp->rbsp_buffer_size = 0;
+        ret = ff_h2645_extract_rbsp(src, length, rbsp, nal, small_padding);
+        if (ret < 0)
+            return 2;
+
+        if (ret != ref_ret || nal->raw_size != ref_ret ||
+            nal->size != ref_size || nal->skipped_bytes != ref_skipped_bytes ||
+            memcmp(nal->data, ref_buf, ref_size) ||
+            memcmp(nal->skipped_bytes_pos, ref_skipped,
+                   ref_skipped_bytes * sizeof(*ref_skipped))) {
+            fprintf(stderr, "%s at %d, length %d, small_padding %d: "
+                    "got %d/%d bytes, %d escapes, expected %d/%d bytes, "
+                    "%d escapes\n", desc, pos, length, small_padding,
+                    ret, nal->size, nal->skipped_bytes,
+                    ref_ret, ref_size, ref_skipped_bytes);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void fill(AVLFG *lfg, uint8_t *src, int length)
+{
+    static const uint8_t pad[] = { 0, 0, 1, 3 };
+    int i;
+
+    for (i = 0; i < length; i++)
+        src[i] = av_lfg_get(lfg) | 4;
+    /* start codes and escapes in the padding must be ignored */
+    for (; src + i < src_buf + sizeof(src_buf); i++)
+        src[i] = pad[av_lfg_get(lfg) & 3];
+}
+
+int main(void)
+{
+    /* each pattern is placed at every offset of every buffer, so it
+     * straddles every position of the scan windows and gets cut short by
+     * the end of the buffer */
+    static const uint8_t patterns[][6] = {
+        { 0, 0, 3 }, { 0, 0, 1 }, { 0, 0, 2 }, { 0, 0, 0 },
+        { 0, 0, 3, 0, 0, 3 }, { 0, 0, 3, 0, 3 }, { 0, 0, 3, 0, 0, 0 },
+        { 0, 0, 0, 3 }, { 0, 0, 3, 1 }, { 0, 3 },
+    };
+    static const int pattern_len[] = { 3, 3, 3, 3, 6, 5, 6, 4, 4, 2 };
+    static const uint8_t dense[] = { 0, 0, 0, 1, 3, 0x80 };
+    H2645RBSP rbsp = { 0 };
+    H2645NAL nal = { 0 };
+    AVLFG lfg;
+    int length, pos, p, i, ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    rbsp.rbsp_buffer = av_malloc(MAX_SIZE + AV_INPUT_BUFFER_PADDING_SIZE);
+    nal.skipped_bytes_pos = av_malloc(sizeof(*nal.skipped_bytes_pos));
+    if (!rbsp.rbsp_buffer || !nal.skipped_bytes_pos) {
+        ret = 2;
+        goto end;
+    }
+    rbsp.rbsp_buffer_alloc_size = MAX_SIZE + AV_INPUT_BUFFER_PADDING_SIZE;
+    nal.skipped_bytes_pos_size  = 1;
+
+    for (length = 0; length <= 40; length++) {
+        uint8_t *src = src_buf + (length & 7);
+
+        fill(&lfg, src, length);
+        ret |= check(&rbsp, &nal, src, length, "no zero", length);
+
+        for (p = 0; p < FF_ARRAY_ELEMS(patterns); p++) {
+            for (pos = 0; pos < length; pos++) {
+                fill(&lfg, src, length);
+                for (i = 0; i < pattern_len[p] && pos + i < length; i++)
+                    src[pos + i] = patterns[p][i];
+                ret |= check(&rbsp, &nal, src, length, "pattern", pos);
+            }
+        }
+    }
+
+    /* buffers with many zeros, escapes and start codes */
+    for (i = 0; i < 4096; i++) {
+        uint8_t *src = src_buf + (i & 7);
+        int j;
+
+        length = av_lfg_get(&lfg) % (MAX_SIZE + 1);
+        fill(&lfg, src, length);
+        for (j = 0; j < length; j++)
+            if (av_lfg_get(&lfg) & 1)
+                src[j] = dense[av_lfg_get(&lfg) % FF_ARRAY_ELEMS(dense)];
+        ret |= check(&rbsp, &nal, src, length, "random", i);
+    }
+
+end:
+    av_freep(&rbsp.rbsp_buffer);
+    av_freep(&nal.skipped_bytes_pos);
+    return ret;
+}
@@ -0,0 +1,256 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavcodec/avcodec.h"
+
+/* 44x40 cropped from 48x48, one IDR and three P pictures with explicit
+ * weighted prediction, deblocking enabled */
+static const uint8_t h264_stream[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x00, 0x28, 0x95, 0xa3, 0x7e, 0xe5,
+    0x40, 0x00, 0x00, 0x00, 0x01, 0x68, 0xcf, 0x01, 0x27, 0x20, 0x00, 0x00,
+    0x00, 0x01, 0x65, 0x88, 0x80, 0x4f, 0x27, 0x8b, 0xb6, 0x23, 0xc2, 0xc8,
+    0x34, 0x4f, 0x6d, 0x62, 0xf4, 0xa4, 0x11, 0x09, 0xb6, 0xb9, 0x76, 0xa4,
+    0x9e, 0xa7, 0x09, 0x4c, 0x01, 0x90, 0x84, 0xde, 0xdc, 0x00, 0x00, 0x00,
+    0x01, 0x61, 0x9a, 0x02, 0x18, 0xd0, 0x28, 0x0e, 0x81, 0x28, 0x40, 0x11,
+    0x13, 0xe4, 0x44, 0x23, 0x1a, 0x25, 0x18, 0x59, 0x4b, 0x16, 0x30, 0xe2,
+    0x04, 0x1c, 0x61, 0x08, 0x72, 0x8a, 0x89, 0x30, 0xbe, 0x67, 0xce, 0x26,
+    0x89, 0xb2, 0x0d, 0x16, 0x74, 0x44, 0x2f, 0x1a, 0x24, 0xa2, 0x85, 0xcb,
+    0xd8, 0xdc, 0x84, 0x4e, 0x48, 0x81, 0x84, 0x65, 0x10, 0x61, 0x22, 0x08,
+    0x30, 0x54, 0xe4, 0x11, 0x90, 0x84, 0x6c, 0x4b, 0x12, 0xd9, 0xc4, 0x94,
+    0x60, 0xc1, 0xa2, 0xca, 0x30, 0x85, 0x23, 0x1a, 0x71, 0x02, 0xd2, 0xc8,
+    0x88, 0x48, 0xd3, 0x98, 0x60, 0x91, 0x62, 0x04, 0x8b, 0x8a, 0x11, 0x3b,
+    0x38, 0xc3, 0x18, 0xb1, 0xb8, 0x00, 0x00, 0x00, 0x01, 0x61, 0x9a, 0x04,
+    0x18, 0xd0, 0x24, 0x60, 0xd9, 0x01, 0x12, 0xfc, 0x69, 0x72, 0x32, 0x29,
+    0xc4, 0x34, 0x31, 0x09, 0x30, 0x91, 0x25, 0x28, 0xb5, 0x3a, 0x15, 0x90,
+    0x88, 0x92, 0xc4, 0x36, 0x72, 0x58, 0x91, 0x22, 0x8a, 0x90, 0xa2, 0x90,
+    0x69, 0x4a, 0x30, 0x65, 0x80, 0x69, 0x3b, 0x1d, 0xa5, 0x62, 0x60, 0x16,
+    0xd2, 0x60, 0x26, 0xdb, 0x6b, 0x2b, 0xcc, 0x67, 0x4c, 0xa9, 0x27, 0x7b,
+    0x51, 0x24, 0x23, 0x6c, 0x68, 0xc1, 0x78, 0x94, 0xa3, 0x4c, 0x28, 0x58,
+    0x81, 0x72, 0x8b, 0x43, 0x73, 0x06, 0x5d, 0xaf, 0x12, 0x10, 0x39, 0x34,
+    0x2f, 0x21, 0x32, 0x14, 0x58, 0xa6, 0x20, 0x49, 0x0e, 0x51, 0x29, 0x8d,
+    0x10, 0xcc, 0x2c, 0x60, 0x81, 0x98, 0x00, 0x00, 0x00, 0x01, 0x61, 0x9a,
+    0x06, 0x18, 0xd0, 0x78, 0x10, 0x83, 0xe1, 0x00, 0x42, 0x12, 0xf9, 0x24,
+    0x73, 0x21, 0x6a, 0x2c, 0xe2, 0xcc, 0x62, 0x31, 0x71, 0xa7, 0xe2, 0x0c,
+    0x12, 0xb0, 0x69, 0xa7, 0x4d, 0xb4, 0x55, 0x62, 0x05, 0xed, 0xd3, 0xa6,
+    0xd3, 0x79, 0x8f, 0x91, 0xd9, 0x06, 0x44, 0x88, 0x16, 0x35, 0xb2, 0x21,
+    0x82, 0x44, 0x1c, 0xa3, 0x50, 0xd1, 0x34, 0x93, 0x54, 0x05, 0x43, 0x4a,
+    0xa3, 0x04, 0x54,
+};
+
+/* 24x24 conformance window in a 32x32 intra picture made of PCM CUs with
+ * 4-bit samples, two tiles, deblocking enabled */
+static const uint8_t hevc_stream[] = {
+    0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+    0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+    0x78, 0xf0, 0x24, 0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60,
+    0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+    0x78, 0xa0, 0x42, 0x08, 0x6d, 0xb7, 0x97, 0xd6, 0xf1, 0x33, 0x54, 0x10,
+    0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71, 0x84, 0xbe, 0x64, 0x80,
+    0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xac, 0x4d, 0x06, 0x00, 0x00, 0x61,
+    0x60, 0xfe, 0xc0, 0x45, 0x55, 0x55, 0x66, 0x67, 0x78, 0x88, 0x89, 0x44,
+    0x45, 0x66, 0x67, 0x77, 0x77, 0x89, 0xaa, 0x45, 0x65, 0x56, 0x66, 0x77,
+    0x88, 0x99, 0x9a, 0x55, 0x66, 0x56, 0x68, 0x77, 0x98, 0x9a, 0x9a, 0x66,
+    0x56, 0x67, 0x77, 0x88, 0x88, 0x99, 0x99, 0x56, 0x67, 0x77, 0x77, 0x88,
+    0x99, 0xa9, 0x9a, 0x65, 0x67, 0x77, 0x78, 0x88, 0x99, 0xaa, 0xaa, 0x56,
+    0x66, 0x77, 0x77, 0x78, 0x99, 0x9a, 0xaa, 0x66, 0x76, 0x77, 0x78, 0x89,
+    0x99, 0x9a, 0xbb, 0x57, 0x67, 0x78, 0x89, 0x89, 0x99, 0x9a, 0xba, 0x76,
+    0x67, 0x77, 0x79, 0x99, 0xaa, 0xaa, 0xbb, 0x77, 0x88, 0x78, 0x89, 0x89,
+    0xaa, 0xaa, 0xbc, 0x67, 0x88, 0x89, 0x88, 0x9a, 0x9a, 0xab, 0xac, 0x77,
+    0x77, 0x99, 0x99, 0x99, 0xaa, 0xac, 0xbb, 0x77, 0x87, 0x99, 0x9a, 0x99,
+    0xaa, 0xbc, 0xbb, 0x77, 0x78, 0x89, 0xa9, 0x99, 0xba, 0xbb, 0xbb, 0x66,
+    0x66, 0x77, 0x77, 0x78, 0x88, 0x88, 0x89, 0x99, 0x99, 0xa6, 0x66, 0x67,
+    0x77, 0x77, 0x78, 0x88, 0x88, 0x99, 0x99, 0x9a, 0xa6, 0x66, 0x67, 0x77,
+    0x77, 0x88, 0x88, 0x89, 0x99, 0x99, 0x9a, 0x89, 0x99, 0x99, 0x9a, 0xaa,
+    0xaa, 0xbb, 0xbb, 0xbc, 0xcc, 0xc8, 0x89, 0x99, 0x99, 0xaa, 0xaa, 0xab,
+    0xbb, 0xbb, 0xbc, 0xcc, 0xc8, 0x99, 0x99, 0x9a, 0xaa, 0xaa, 0xab, 0xbb,
+    0xbb, 0xcc, 0xcc, 0xfd, 0xc0, 0xa9, 0xaa, 0xab, 0xbc, 0xcc, 0xcc, 0xde,
+    0xdd, 0xaa, 0xba, 0xab, 0xbc, 0xcc, 0xcc, 0xdd, 0xde, 0x99, 0xaa, 0xbc,
+    0xbb, 0xcc, 0xdd, 0xde, 0xee, 0x9a, 0xaa, 0xbb, 0xcc, 0xcc, 0xde, 0xee,
+    0xee, 0xaa, 0xba, 0xbc, 0xbc, 0xdd, 0xdd, 0xee, 0xee, 0x9b, 0xab, 0xbc,
+    0xdd, 0xcd, 0xdd, 0xee, 0xee, 0xab, 0xab, 0xbc, 0xcd, 0xcd, 0xde, 0xde,
+    0xee, 0xba, 0xbc, 0xcc, 0xcd, 0xdd, 0xee, 0xee, 0xee, 0xbb, 0xbb, 0xbd,
+    0xcd, 0xed, 0xee, 0xee, 0xee, 0xab, 0xbc, 0xcc, 0xdd, 0xdd, 0xee, 0xee,
+    0xee, 0xbc, 0xbc, 0xcc, 0xdd, 0xde, 0xee, 0xee, 0xee, 0xbc, 0xbc, 0xcd,
+    0xcd, 0xee, 0xee, 0xee, 0xee, 0xcc, 0xdc, 0xcd, 0xde, 0xee, 0xee, 0xee,
+    0xee, 0xcc, 0xdd, 0xdd, 0xdd, 0xee, 0xee, 0xee, 0xee, 0xcc, 0xcc, 0xdd,
+    0xee, 0xee, 0xee, 0xee, 0xee, 0xcc, 0xdd, 0xde, 0xee, 0xee, 0xee, 0xee,
+    0xee, 0x77, 0x77, 0x78, 0x88, 0x88, 0x99, 0x99, 0x99, 0xa6, 0x66, 0x67,
+    0x77, 0x77, 0x88, 0x88, 0x88, 0x99, 0x99, 0x9a, 0x66, 0x66, 0x77, 0x77,
+    0x77, 0x88, 0x88, 0x89, 0x99, 0x99, 0xaa, 0x66, 0x66, 0x99, 0xaa, 0xaa,
+    0xaa, 0xbb, 0xbb, 0xbc, 0xcc, 0xc8, 0x99, 0x99, 0x99, 0xaa, 0xaa, 0xab,
+    0xbb, 0xbb, 0xcc, 0xcc, 0x88, 0x99, 0x99, 0x9a, 0xaa, 0xaa, 0xbb, 0xbb,
+    0xbb, 0xcc, 0xcc, 0x89, 0x99, 0xfd, 0x80, 0xfe, 0xc0, 0x88, 0x88, 0x99,
+    0x9a, 0x9b, 0xab, 0xbb, 0xbb, 0x88, 0x98, 0x89, 0x99, 0xab, 0xbb, 0xbb,
+    0xbc, 0x88, 0x98, 0x9a, 0xaa, 0xab, 0xac, 0xcb, 0xcc, 0x88, 0x88, 0xaa,
+    0x9a, 0xab, 0xbc, 0xcc, 0xcd, 0x89, 0x98, 0xaa, 0xaa, 0xbb, 0xcb, 0xcd,
+    0xcd, 0x88, 0x99, 0xaa, 0xaa, 0xbb, 0xbc, 0xcc, 0xdd, 0x98, 0x99, 0x9b,
+    0xab, 0xbb, 0xbc, 0xcc, 0xdd, 0x88, 0x99, 0xaa, 0xaa, 0xbb, 0xbc, 0xdd,
+    0xde, 0x89, 0xa9, 0xaa, 0xab, 0xcc, 0xcd, 0xdd, 0xde, 0x99, 0x9a, 0xbb,
+    0xab, 0xcc, 0xcc, 0xdd, 0xee, 0x99, 0x9a, 0xbb, 0xbc, 0xbc, 0xdd, 0xcd,
+    0xee, 0x9a, 0xab, 0xbb, 0xbc, 0xcc, 0xcc, 0xee, 0xee, 0xaa, 0xab, 0xab,
+    0xcb, 0xdc, 0xdd, 0xdd, 0xde, 0xaa, 0xab, 0xab, 0xcc, 0xcd, 0xde, 0xde,
+    0xee, 0x9b, 0xbc, 0xbb, 0xdd, 0xcd, 0xde, 0xee, 0xee, 0xba, 0xbb, 0xcb,
+    0xcd, 0xde, 0xde, 0xde, 0xee, 0x99, 0x99, 0xa6, 0x66, 0x67, 0x77, 0x77,
+    0x88, 0x88, 0x88, 0x99, 0x99, 0x9a, 0x66, 0x66, 0x77, 0x77, 0x77, 0x88,
+    0x88, 0x89, 0x99, 0x99, 0xaa, 0x66, 0x66, 0x77, 0x77, 0x78, 0x88, 0x88,
+    0x99, 0xbc, 0xcc, 0xc8, 0x99, 0x99, 0x99, 0xaa, 0xaa, 0xab, 0xbb, 0xbb,
+    0xcc, 0xcc, 0x88, 0x99, 0x99, 0x9a, 0xaa, 0xaa, 0xbb, 0xbb, 0xbb, 0xcc,
+    0xcc, 0x89, 0x99, 0x99, 0xaa, 0xaa, 0xaa, 0xbb, 0xbb, 0xfd, 0xc0, 0x46,
+    0x56, 0x67, 0x67, 0x78, 0x88, 0x89, 0x99, 0x45, 0x57, 0x77, 0x77, 0x88,
+    0x88, 0x99, 0x9a, 0x55, 0x66, 0x66, 0x87, 0x88, 0x89, 0x89, 0xa9, 0x66,
+    0x66, 0x77, 0x87, 0x98, 0x89, 0xa9, 0x99, 0x55, 0x67, 0x78, 0x88, 0x88,
+    0x99, 0x9a, 0xaa, 0x76, 0x67, 0x78, 0x88, 0x89, 0x8a, 0xaa, 0xaa, 0x66,
+    0x76, 0x78, 0x88, 0x99, 0xa9, 0x9a, 0xaa, 0x66, 0x78, 0x88, 0x99, 0x99,
+    0x9a, 0xaa, 0xba, 0x66, 0x77, 0x89, 0x88, 0x89, 0x99, 0xbb, 0xab, 0x77,
+    0x68, 0x89, 0x99, 0x99, 0xaa, 0xbb, 0xbb, 0x78, 0x88, 0x98, 0x88, 0x99,
+    0xba, 0xab, 0xbc, 0x77, 0x88, 0x88, 0x9a, 0x99, 0xab, 0xbb, 0xcc, 0x78,
+    0x88, 0x89, 0xa9, 0xaa, 0xab, 0xbb, 0xbb, 0x88, 0x88, 0x98, 0x9a, 0x9a,
+    0xab, 0xbc, 0xbc, 0x88, 0x79, 0x9a, 0x9a, 0xaa, 0xaa, 0xbb, 0xcb, 0x78,
+    0x89, 0xa9, 0xaa, 0xbb, 0xaa, 0xbc, 0xcc, 0x67, 0x77, 0x77, 0x88, 0x88,
+    0x88, 0x99, 0x99, 0x9a, 0x66, 0x66, 0x77, 0x77, 0x77, 0x88, 0x88, 0x89,
+    0x99, 0x99, 0xaa, 0x66, 0x66, 0x77, 0x77, 0x78, 0x88, 0x88, 0x99, 0x99,
+    0x99, 0xa6, 0x66, 0x99, 0x99, 0xaa, 0xaa, 0xab, 0xbb, 0xbb, 0xcc, 0xcc,
+    0x88, 0x99, 0x99, 0x9a, 0xaa, 0xaa, 0xbb, 0xbb, 0xbb, 0xcc, 0xcc, 0x89,
+    0x99, 0x99, 0xaa, 0xaa, 0xaa, 0xbb, 0xbb, 0xbc, 0xcc, 0xc8, 0x99, 0xfe,
+    0x80,
+};
+
+static void print_frame(const AVFrame *frame, int lowres, int n)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    unsigned long crc = 0;
+    int p, y;
+
+    for (p = 0; p < 3; p++) {
+        int w = p ? AV_CEIL_RSHIFT(frame->width,  desc->log2_chroma_w) : frame->width;
+        int h = p ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+        for (y = 0; y < h; y++)
+            crc = av_adler32_update(crc, frame->data[p] + y * frame->linesize[p], w);
+    }
+    printf("lowres %d, frame %d, %dx%d, 0x%08lx\n",
+           lowres, n, frame->width, frame->height, crc);
+}
+
+static int decode(AVCodecContext *avctx, AVPacket *pkt, AVFrame *frame,
+                  int lowres, int *n)
+{
+    int ret = avcodec_send_packet(avctx, pkt);
+    if (ret < 0)
+        return ret;
+
+    while ((ret = avcodec_receive_frame(avctx, frame)) >= 0) {
+        print_frame(frame, lowres, (*n)++);
+        av_frame_unref(frame);
+    }
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+static int decode_stream(const AVCodec *codec, const uint8_t *data, int size,
+                         int lowres)
+{
+    AVCodecParserContext *parser = av_parser_init(codec->id);
+    AVCodecContext *avctx = avcodec_alloc_context3(codec);
+    AVPacket *pkt  = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    int ret, n = 0;
+
+    if (!parser || !avctx || !pkt || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    avctx->lowres       = lowres;
+    avctx->thread_count = 1;
+    avctx->flags       |= AV_CODEC_FLAG_UNALIGNED;
+    ret = avcodec_open2(avctx, codec, NULL);
+    if (ret < 0)
+        goto end;
+
+    while (size > 0) {
+        ret = av_parser_parse2(parser, avctx, &pkt->data, &pkt->size,
+                               data, size, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+        if (ret < 0)
+            goto end;
+        data += ret;
+        size -= ret;
+        if (pkt->size && (ret = decode(avctx, pkt, frame, lowres, &n)) < 0)
+            goto end;
+    }
+    ret = av_parser_parse2(parser, avctx, &pkt->data, &pkt->size,
+                           NULL, 0, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+    if (ret < 0)
+        goto end;
+    if (pkt->size && (ret = decode(avctx, pkt, frame, lowres, &n)) < 0)
+        goto end;
+    ret = decode(avctx, NULL, frame, lowres, &n);
+
+end:
+    av_parser_close(parser);
+    avcodec_free_context(&avctx);
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const AVCodec *codec;
+    const uint8_t *data;
+    int size, lowres, ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <h264|hevc>\n", argv[0]);
+        return 1;
+    }
+
+    if (!strcmp(argv[1], "h264")) {
+        data = h264_stream;
+        size = sizeof(h264_stream);
+    } else if (!strcmp(argv[1], "hevc")) {
+        data = hevc_stream;
+        size = sizeof(hevc_stream);
+    } else {
+        fprintf(stderr, "Unknown decoder %s\n", argv[1]);
+        return 1;
+    }
+
+    codec = avcodec_find_decoder_by_name(argv[1]);
+    if (!codec) {
+        fprintf(stderr, "Decoder %s not found\n", argv[1]);
+        return 1;
+    }
+
+    /* the full resolution decode is the reference the others approximate */
+    for (lowres = 0; lowres <= 2; lowres++) {
+        ret = decode_stream(codec, data, size, lowres);
+        if (ret < 0) {
+            fprintf(stderr, "Decoding at lowres %d failed: %s\n",
+                    lowres, av_err2str(ret));
+            return 1;
+        }
+    }
+    return 0;
+}
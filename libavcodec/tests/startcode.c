@@ -0,0 +1,108 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/internal.h"
+#include "libavcodec/startcode.h"
+
+#define MAX_SIZE 64
+
+DECLARE_ALIGNED(16, static uint8_t, buf)[MAX_SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
+
+static int ref_find_candidate(const uint8_t *buf, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        if (!buf[i])
+            break;
+    return i;
+}
+
+/* Without a candidate the position only has to be at or past the end,
+ * callers continue their own search from there. */
+static int check(int size, const char *desc, int pos)
+{
+    int ref = ref_find_candidate(buf, size);
+    int res = ff_startcode_find_candidate_c(buf, size);
+
+    if (ref < size ? res != ref : res < size) {
+        fprintf(stderr, "%s at %d, size %d: got %d, expected %d\n",
+                desc, pos, size, res, ref);
+        return 1;
+    }
+    return 0;
+}
+
+static void fill(AVLFG *lfg, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        buf[i] = av_lfg_get(lfg) | 1;
+    /* zeros in the padding must not be reported */
+    for (; i < sizeof(buf); i++)
+        buf[i] = av_lfg_get(lfg) & 1;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int size, pos, ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (size = 0; size <= MAX_SIZE; size++) {
+        fill(&lfg, size);
+        ret |= check(size, "no zero", size);
+
+        /* a lone zero at every offset, including both ends of a word */
+        for (pos = 0; pos < size; pos++) {
+            fill(&lfg, size);
+            buf[pos] = 0;
+            ret |= check(size, "zero", pos);
+        }
+
+        /* a full start code at every offset, truncated by the end of the
+         * buffer for the last ones */
+        for (pos = 0; pos < size; pos++) {
+            fill(&lfg, size);
+            buf[pos] = 0;
+            if (pos + 1 < size)
+                buf[pos + 1] = 0;
+            if (pos + 2 < size)
+                buf[pos + 2] = 1;
+            ret |= check(size, "start code", pos);
+        }
+
+        /* two zeros, the second one found only if the first is missed */
+        for (pos = 0; pos + 9 < size; pos++) {
+            fill(&lfg, size);
+            buf[pos]     = 0;
+            buf[pos + 9] = 0;
+            ret |= check(size, "zero pair", pos);
+        }
+    }
+
+    return ret;
+}
@@ -51,6 +51,11 @@
 #include "thread.h"
 #include "get_bits.h"
 
+typedef struct TiffStrip {
+    unsigned offset, size;
+    int ret;
+} TiffStrip;
+
 typedef struct TiffContext {
     AVClass *class;
     AVCodecContext *avctx;
@@ -95,6 +100,10 @@ typedef struct TiffContext {
     int sot;
     int stripsizesoff, stripsize, stripoff, strippos;
     LZWState *lzw;
+    LZWState **slice_lzw;        ///< LZW states of the additional slice threads
+    int nb_slice_lzw;
+    TiffStrip *strip_table;
+    unsigned int strip_table_size;
 
     /* Tile support */
     int is_tiled;
@@ -556,8 +565,10 @@ static int tiff_unpack_fax(TiffContext *s, uint8_t *dst, int stride,
 static int dng_decode_strip(AVCodecContext *avctx, AVFrame *frame);
 
 static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int stride,
-                             const uint8_t *src, int size, int strip_start, int lines)
+                             const uint8_t *src, int size, int strip_start, int lines,
+                             LZWState *lzw)
 {
+    GetByteContext gb;
     PutByteContext pb;
     int c, line, pixels, code, ret;
     const uint8_t *ssrc = src;
@@ -633,12 +644,12 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         if (size > 1 && !src[0] && (src[1]&1)) {
             av_log(s->avctx, AV_LOG_ERROR, "Old style LZW is unsupported\n");
         }
-        if ((ret = ff_lzw_decode_init(s->lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
+        if ((ret = ff_lzw_decode_init(lzw, 8, src, size, FF_LZW_TIFF)) < 0) {
             av_log(s->avctx, AV_LOG_ERROR, "Error initializing LZW decoder\n");
             return ret;
         }
         for (line = 0; line < lines; line++) {
-            pixels = ff_lzw_decode(s->lzw, dst, width);
+            pixels = ff_lzw_decode(lzw, dst, width);
             if (pixels < width) {
                 av_log(s->avctx, AV_LOG_ERROR, "Decoded only %i bytes of %i\n",
                        pixels, width);
@@ -665,7 +676,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
         return tiff_unpack_fax(s, dst, stride, src, size, width, lines);
     }
 
-    bytestream2_init(&s->gb, src, size);
+    bytestream2_init(&gb, src, size);
     bytestream2_init_writer(&pb, dst, is_yuv ? s->yuv_line_size : (stride * lines));
 
     is_dng = (s->tiff_type == TIFF_TYPE_DNG || s->tiff_type == TIFF_TYPE_CINEMADNG);
@@ -676,6 +687,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
             av_log(s->avctx, AV_LOG_ERROR, "More than one DNG JPEG strips unsupported\n");
             return AVERROR_PATCHWELCOME;
         }
+        s->gb = gb;
         if ((ret = dng_decode_strip(s->avctx, p)) < 0)
             return ret;
         return 0;
@@ -690,7 +702,7 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
             return AVERROR_INVALIDDATA;
         }
 
-        if (bytestream2_get_bytes_left(&s->gb) == 0 || bytestream2_get_eof(&pb))
+        if (bytestream2_get_bytes_left(&gb) == 0 || bytestream2_get_eof(&pb))
             break;
         bytestream2_seek_p(&pb, stride * line, SEEK_SET);
         switch (s->compr) {
@@ -780,6 +792,54 @@ static int tiff_unpack_strip(TiffContext *s, AVFrame *p, uint8_t *dst, int strid
     return 0;
 }
 
+typedef struct TiffStripThreadArg {
+    AVFrame *p;
+    const uint8_t *buf;
+    uint8_t *dst;
+    int stride;
+} TiffStripThreadArg;
+
+static int tiff_decode_strip(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    TiffContext *s = avctx->priv_data;
+    const TiffStripThreadArg *t = arg;
+    TiffStrip *strip = &s->strip_table[jobnr];
+    int start = jobnr * s->rps;
+
+    strip->ret = tiff_unpack_strip(s, t->p, t->dst + start * t->stride, t->stride,
+                                   t->buf + strip->offset, strip->size, start,
+                                   FFMIN(s->rps, s->height - start),
+                                   threadnr ? s->slice_lzw[threadnr - 1] : s->lzw);
+    return 0;
+}
+
+/* Strips only share the scratch buffers of the context for YUV, 12 bit gray,
+ * bit reversed and fax data, and the JPEG decoder for DNG; all other
+ * strips can be decoded in parallel. */
+static int tiff_strips_threadable(TiffContext *s, const AVFrame *p)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(p->format);
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_SLICE) ||
+        s->fill_order || p->format == AV_PIX_FMT_GRAY12)
+        return 0;
+    if (!(desc->flags & AV_PIX_FMT_FLAG_RGB) &&
+        (desc->flags & AV_PIX_FMT_FLAG_PLANAR) && desc->nb_components >= 3)
+        return 0;
+
+    switch (s->compr) {
+    case TIFF_RAW:
+    case TIFF_PACKBITS:
+    case TIFF_LZW:
+    case TIFF_DEFLATE:
+    case TIFF_ADOBE_DEFLATE:
+    case TIFF_LZMA:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 /**
  * Map stored raw sensor values into linear reference values (see: DNG Specification - Chapter 5)
  */
@@ -1989,6 +2049,7 @@ again:
         uint8_t *five_planes = NULL;
         int remaining = avpkt->size;
         int decoded_height;
+        int nb_strips = (s->height + s->rps - 1) / s->rps;
         stride = p->linesize[plane];
         dst = p->data[plane];
         if (s->photometric == TIFF_PHOTOMETRIC_SEPARATED &&
@@ -1999,9 +2060,13 @@ again:
             if (!dst)
                 return AVERROR(ENOMEM);
         }
-        for (i = 0; i < s->height; i += s->rps) {
-            if (i)
-                dst += s->rps * stride;
+        av_fast_malloc(&s->strip_table, &s->strip_table_size,
+                       nb_strips * sizeof(*s->strip_table));
+        if (!s->strip_table) {
+            av_freep(&five_planes);
+            return AVERROR(ENOMEM);
+        }
+        for (i = 0; i < nb_strips; i++) {
             if (s->stripsizesoff)
                 ssize = ff_tget(&stripsizes, s->sstype, le);
             else
@@ -2018,16 +2083,39 @@ again:
                 return AVERROR_INVALIDDATA;
             }
             remaining -= ssize;
-            if ((ret = tiff_unpack_strip(s, p, dst, stride, avpkt->data + soff, ssize, i,
-                                         FFMIN(s->rps, s->height - i))) < 0) {
-                if (avctx->err_recognition & AV_EF_EXPLODE) {
-                    av_freep(&five_planes);
-                    return ret;
-                }
-                break;
+            s->strip_table[i].offset = soff;
+            s->strip_table[i].size   = ssize;
+        }
+
+        if (tiff_strips_threadable(s, p)) {
+            TiffStripThreadArg t = {
+                .p      = p,
+                .buf    = avpkt->data,
+                .dst    = dst,
+                .stride = stride,
+            };
+            avctx->execute2(avctx, tiff_decode_strip, &t, NULL, nb_strips);
+            for (i = 0; i < nb_strips; i++)
+                if (s->strip_table[i].ret < 0)
+                    break;
+        } else {
+            for (i = 0; i < nb_strips; i++) {
+                if (i)
+                    dst += s->rps * stride;
+                s->strip_table[i].ret =
+                    tiff_unpack_strip(s, p, dst, stride,
+                                      avpkt->data + s->strip_table[i].offset,
+                                      s->strip_table[i].size, i * s->rps,
+                                      FFMIN(s->rps, s->height - i * s->rps), s->lzw);
+                if (s->strip_table[i].ret < 0)
+                    break;
             }
         }
-        decoded_height = FFMIN(i, s->height);
+        if (i < nb_strips && avctx->err_recognition & AV_EF_EXPLODE) {
+            av_freep(&five_planes);
+            return s->strip_table[i].ret;
+        }
+        decoded_height = FFMIN(i * s->rps, s->height);
 
         if (s->predictor == 2) {
             if (s->photometric == TIFF_PHOTOMETRIC_YCBCR) {
@@ -2154,6 +2242,16 @@ static av_cold int tiff_init(AVCodecContext *avctx)
     ff_lzw_decode_open(&s->lzw);
     if (!s->lzw)
         return AVERROR(ENOMEM);
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1) {
+        s->slice_lzw = av_calloc(avctx->thread_count - 1, sizeof(*s->slice_lzw));
+        if (!s->slice_lzw)
+            return AVERROR(ENOMEM);
+        for (; s->nb_slice_lzw < avctx->thread_count - 1; s->nb_slice_lzw++) {
+            ff_lzw_decode_open(&s->slice_lzw[s->nb_slice_lzw]);
+            if (!s->slice_lzw[s->nb_slice_lzw])
+                return AVERROR(ENOMEM);
+        }
+    }
     ff_ccitt_unpack_init();
 
     /* Allocate JPEG frame */
@@ -2184,10 +2282,15 @@ static av_cold int tiff_init(AVCodecContext *avctx)
 static av_cold int tiff_end(AVCodecContext *avctx)
 {
     TiffContext *const s = avctx->priv_data;
+    int i;
 
     free_geotags(s);
 
     ff_lzw_decode_close(&s->lzw);
+    for (i = 0; i < s->nb_slice_lzw; i++)
+        ff_lzw_decode_close(&s->slice_lzw[i]);
+    av_freep(&s->slice_lzw);
+    av_freep(&s->strip_table);
     av_freep(&s->deinvert_buf);
     s->deinvert_buf_size = 0;
     av_freep(&s->yuv_line);
@@ -2224,7 +2327,8 @@ AVCodec ff_tiff_decoder = {
     .init           = tiff_init,
     .close          = tiff_end,
     .decode         = decode_frame,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE | FF_CODEC_CAP_INIT_CLEANUP,
     .priv_class     = &tiff_decoder_class,
 };
@@ -879,8 +879,7 @@ static int floor_encode(vorbis_enc_context *venc, vorbis_enc_floor *fc,
     return 0;
 }
 
-static float *put_vector(vorbis_enc_codebook *book, PutBitContext *pb,
-                         float *num)
+static int find_vector_entry(const vorbis_enc_codebook *book, const float *num)
 {
     int i, entry = -1;
     float distance = FLT_MAX;
@@ -897,24 +896,98 @@ static float *put_vector(vorbis_enc_codebook *book, PutBitContext *pb,
             distance = d;
         }
     }
-    if (put_codeword(pb, book, entry))
-        return NULL;
-    return &book->dimensions[entry * book->ndimensions];
+    return entry;
 }
 
-static int residue_encode(vorbis_enc_context *venc, vorbis_enc_residue *rc,
-                          PutBitContext *pb, float *coeffs, int samples,
-                          int real_ch)
+typedef struct ResidueSearch {
+    vorbis_enc_context *venc;
+    vorbis_enc_residue *rc;
+    float *coeffs;
+    int samples;
+    int real_ch;
+    int pass;
+    const int *classes;
+    int *entries;
+} ResidueSearch;
+
+/**
+ * Quantize one partition of a residue pass and store the chosen codebook
+ * entries. Partitions cover disjoint coefficients, so they can be searched
+ * in parallel and written out in order afterwards.
+ */
+static int residue_search_partition(AVCodecContext *avctx, void *arg,
+                                    int p, int threadnr)
+{
+    ResidueSearch *rs = arg;
+    vorbis_enc_residue *rc = rs->rc;
+    float *coeffs = rs->coeffs;
+    int psize   = rc->partition_size;
+    int samples = rs->samples, real_ch = rs->real_ch;
+    int nbook   = rc->books[rs->classes[p]][rs->pass];
+    int *entries = rs->entries + p * psize;
+    vorbis_enc_codebook *book;
+    int s, a1, b1, k;
+
+    if (nbook == -1)
+        return 0;
+    book = &rs->venc->codebooks[nbook];
+
+    assert(!(psize % book->ndimensions));
+
+    s  = rc->begin + p * psize;
+    a1 = (s % real_ch) * samples;
+    b1 =  s / real_ch;
+    s  = real_ch * samples;
+    for (k = 0; k < psize; k += book->ndimensions) {
+        int dim, a2 = a1, b2 = b1, entry;
+        float vec[MAX_CODEBOOK_DIM], *pv = vec;
+        for (dim = book->ndimensions; dim--; ) {
+            *pv++ = coeffs[a2 + b2];
+            if ((a2 += samples) == s) {
+                a2 = 0;
+                b2++;
+            }
+        }
+        entry = find_vector_entry(book, vec);
+        *entries++ = entry;
+        if (entry < 0)
+            return AVERROR(EINVAL);
+        pv = &book->dimensions[entry * book->ndimensions];
+        for (dim = book->ndimensions; dim--; ) {
+            coeffs[a1 + b1] -= *pv++;
+            if ((a1 += samples) == s) {
+                a1 = 0;
+                b1++;
+            }
+        }
+    }
+    return 0;
+}
+
+static int residue_encode(AVCodecContext *avctx, vorbis_enc_context *venc,
+                          vorbis_enc_residue *rc, PutBitContext *pb,
+                          float *coeffs, int samples, int real_ch)
 {
     int pass, i, j, p, k;
     int psize      = rc->partition_size;
     int partitions = (rc->end - rc->begin) / psize;
     int channels   = (rc->type == 2) ? 1 : real_ch;
     int classes[MAX_CHANNELS][NUM_RESIDUE_PARTITIONS];
+    int entries[NUM_RESIDUE_PARTITIONS * RESIDUE_PART_SIZE];
     int classwords = venc->codebooks[rc->classbook].ndimensions;
+    ResidueSearch rs = {
+        .venc    = venc,
+        .rc      = rc,
+        .coeffs  = coeffs,
+        .samples = samples,
+        .real_ch = real_ch,
+        .classes = classes[0],
+        .entries = entries,
+    };
 
     av_assert0(rc->type == 2);
     av_assert0(real_ch == 2);
+    av_assert0(partitions <= NUM_RESIDUE_PARTITIONS && psize <= RESIDUE_PART_SIZE);
     for (p = 0; p < partitions; p++) {
         float max1 = 0.0, max2 = 0.0;
         int s = rc->begin + p * psize;
@@ -930,6 +1003,14 @@ static int residue_encode(vorbis_enc_context *venc, vorbis_enc_residue *rc,
     }
 
     for (pass = 0; pass < 8; pass++) {
+        int ret[NUM_RESIDUE_PARTITIONS];
+
+        rs.pass = pass;
+        avctx->execute2(avctx, residue_search_partition, &rs, ret, partitions);
+        for (p = 0; p < partitions; p++)
+            if (ret[p] < 0)
+                return ret[p];
+
         p = 0;
         while (p < partitions) {
             if (pass == 0)
@@ -944,53 +1025,14 @@ static int residue_encode(vorbis_enc_context *venc, vorbis_enc_residue *rc,
                         return AVERROR(EINVAL);
                 }
             for (i = 0; i < classwords && p < partitions; i++, p++) {
-                for (j = 0; j < channels; j++) {
-                    int nbook = rc->books[classes[j][p]][pass];
-                    vorbis_enc_codebook * book = &venc->codebooks[nbook];
-                    float *buf = coeffs + samples*j + rc->begin + p*psize;
-                    if (nbook == -1)
-                        continue;
-
-                    assert(rc->type == 0 || rc->type == 2);
-                    assert(!(psize % book->ndimensions));
-
-                    if (rc->type == 0) {
-                        for (k = 0; k < psize; k += book->ndimensions) {
-                            int l;
-                            float *a = put_vector(book, pb, &buf[k]);
-                            if (!a)
-                                return AVERROR(EINVAL);
-                            for (l = 0; l < book->ndimensions; l++)
-                                buf[k + l] -= a[l];
-                        }
-                    } else {
-                        int s = rc->begin + p * psize, a1, b1;
-                        a1 = (s % real_ch) * samples;
-                        b1 =  s / real_ch;
-                        s  = real_ch * samples;
-                        for (k = 0; k < psize; k += book->ndimensions) {
-                            int dim, a2 = a1, b2 = b1;
-                            float vec[MAX_CODEBOOK_DIM], *pv = vec;
-                            for (dim = book->ndimensions; dim--; ) {
-                                *pv++ = coeffs[a2 + b2];
-                                if ((a2 += samples) == s) {
-                                    a2 = 0;
-                                    b2++;
-                                }
-                            }
-                            pv = put_vector(book, pb, vec);
-                            if (!pv)
-                                return AVERROR(EINVAL);
-                            for (dim = book->ndimensions; dim--; ) {
-                                coeffs[a1 + b1] -= *pv++;
-                                if ((a1 += samples) == s) {
-                                    a1 = 0;
-                                    b1++;
-                                }
-                            }
-                        }
-                    }
-                }
+                int nbook = rc->books[classes[0][p]][pass];
+                vorbis_enc_codebook * book = &venc->codebooks[nbook];
+                if (nbook == -1)
+                    continue;
+
+                for (k = 0; k < psize / book->ndimensions; k++)
+                    if (put_codeword(pb, book, entries[p * psize + k]))
+                        return AVERROR(EINVAL);
             }
         }
     }
@@ -1178,7 +1220,7 @@ static int vorbis_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         }
     }
 
-    if (residue_encode(venc, &venc->residues[mapping->residue[mapping->mux[0]]],
+    if (residue_encode(avctx, venc, &venc->residues[mapping->residue[mapping->mux[0]]],
                        &pb, venc->coeffs, frame_size, venc->channels)) {
         av_log(avctx, AV_LOG_ERROR, "output buffer is too small\n");
         return AVERROR(EINVAL);
@@ -1307,7 +1349,7 @@ AVCodec ff_vorbis_encoder = {
     .init           = vorbis_encode_init,
     .encode2        = vorbis_encode_frame,
     .close          = vorbis_encode_close,
-    .capabilities   = AV_CODEC_CAP_DELAY | AV_CODEC_CAP_EXPERIMENTAL,
+    .capabilities   = AV_CODEC_CAP_DELAY | AV_CODEC_CAP_EXPERIMENTAL | AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
 };
@@ -89,9 +89,122 @@ static void vp9_await_tile_progress(VP9Context *s, int field, int n) {
         pthread_cond_wait(&s->progress_cond, &s->progress_mutex);
     pthread_mutex_unlock(&s->progress_mutex);
 }
+
+static void loopfilter_sbrow(AVCodecContext *avctx, VP9Filter *lflvl_ptr, int sbrow)
+{
+    VP9Context *s = avctx->priv_data;
+    AVFrame *f = s->s.frames[CUR_FRAME].tf.f;
+    ptrdiff_t yoff = (f->linesize[0] * 64) * sbrow;
+    ptrdiff_t uvoff = (f->linesize[1] * 64 >> s->ss_v) * sbrow;
+    int bytesperpixel = s->bytesperpixel, col;
+
+    for (col = 0; col < s->cols;
+         col += 8, yoff += 64 * bytesperpixel,
+         uvoff += 64 * bytesperpixel >> s->ss_h, lflvl_ptr++) {
+        ff_vp9_loopfilter_sb(avctx, lflvl_ptr, sbrow << 3, col, yoff, uvoff);
+    }
+}
+
+/* With frame threading, each decoding thread hands its reconstructed sb64
+ * rows to a loopfilter worker, so that the filtering of one row overlaps
+ * with the reconstruction of the next. The worker reports the frame
+ * progress once a row is filtered. Running the two concurrently is safe
+ * for the same reason as in loopfilter_proc(): intra prediction of the
+ * next row reads the pre-loopfilter data from s->intra_pred_data[]. */
+static void *loopfilter_worker(void *arg)
+{
+    AVCodecContext *avctx = arg;
+    VP9Context *s = avctx->priv_data;
+
+    pthread_mutex_lock(&s->lf_mutex);
+    while (1) {
+        int sbrow;
+
+        while (s->lf_rows_done == s->lf_rows_ready && !s->lf_exit)
+            pthread_cond_wait(&s->lf_cond, &s->lf_mutex);
+        if (s->lf_exit)
+            break;
+        sbrow = s->lf_rows_done;
+        pthread_mutex_unlock(&s->lf_mutex);
+
+        loopfilter_sbrow(avctx, s->lflvl + s->sb_cols * sbrow, sbrow);
+        ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, sbrow, 0);
+
+        pthread_mutex_lock(&s->lf_mutex);
+        s->lf_rows_done++;
+        pthread_cond_signal(&s->lf_done_cond);
+    }
+    pthread_mutex_unlock(&s->lf_mutex);
+
+    return NULL;
+}
+
+static av_cold int vp9_lf_thread_init(AVCodecContext *avctx)
+{
+    VP9Context *s = avctx->priv_data;
+    int ret;
+
+    if (!(avctx->active_thread_type & FF_THREAD_FRAME))
+        return 0;
+
+    pthread_mutex_init(&s->lf_mutex, NULL);
+    pthread_cond_init(&s->lf_cond, NULL);
+    pthread_cond_init(&s->lf_done_cond, NULL);
+    ret = pthread_create(&s->lf_thread, NULL, loopfilter_worker, avctx);
+    if (ret) {
+        pthread_mutex_destroy(&s->lf_mutex);
+        pthread_cond_destroy(&s->lf_cond);
+        pthread_cond_destroy(&s->lf_done_cond);
+        return AVERROR(ret);
+    }
+    s->lf_thread_init = 1;
+
+    return 0;
+}
+
+static av_cold void vp9_lf_thread_free(VP9Context *s)
+{
+    if (!s->lf_thread_init)
+        return;
+
+    pthread_mutex_lock(&s->lf_mutex);
+    s->lf_exit = 1;
+    pthread_cond_signal(&s->lf_cond);
+    pthread_mutex_unlock(&s->lf_mutex);
+    pthread_join(s->lf_thread, NULL);
+
+    pthread_mutex_destroy(&s->lf_mutex);
+    pthread_cond_destroy(&s->lf_cond);
+    pthread_cond_destroy(&s->lf_done_cond);
+    s->lf_thread_init = 0;
+}
+
+static void vp9_lf_post_row(VP9Context *s)
+{
+    pthread_mutex_lock(&s->lf_mutex);
+    s->lf_rows_ready++;
+    pthread_cond_signal(&s->lf_cond);
+    pthread_mutex_unlock(&s->lf_mutex);
+}
+
+// wait until the loopfilter worker has filtered all posted rows
+static void vp9_lf_wait(VP9Context *s)
+{
+    if (!s->lf_thread_init)
+        return;
+
+    pthread_mutex_lock(&s->lf_mutex);
+    while (s->lf_rows_done != s->lf_rows_ready)
+        pthread_cond_wait(&s->lf_done_cond, &s->lf_mutex);
+    s->lf_rows_done = s->lf_rows_ready = 0;
+    pthread_mutex_unlock(&s->lf_mutex);
+}
 #else
 static void vp9_free_entries(AVCodecContext *avctx) {}
 static int vp9_alloc_entries(AVCodecContext *avctx, int n) { return 0; }
+static int vp9_lf_thread_init(AVCodecContext *avctx) { return 0; }
+static void vp9_lf_thread_free(VP9Context *s) {}
+static void vp9_lf_wait(VP9Context *s) {}
 #endif
 
 static void vp9_tile_data_free(VP9TileData *td)
@@ -262,7 +375,7 @@ static int update_size(AVCodecContext *avctx, int w, int h)
     s->sb_rows   = (h + 63) >> 6;
     s->cols      = (w + 7) >> 3;
     s->rows      = (h + 7) >> 3;
-    lflvl_len    = avctx->active_thread_type == FF_THREAD_SLICE ? s->sb_rows : 1;
+    lflvl_len    = avctx->active_thread_type ? s->sb_rows : 1;
 
 #define assign(var, type, n) var = (type) p; p += s->sb_cols * (n) * sizeof(*var)
     av_freep(&s->intra_pred_data[0]);
@@ -1250,6 +1363,7 @@ static av_cold int vp9_decode_free(AVCodecContext *avctx)
         av_frame_free(&s->next_refs[i].f);
     }
 
+    vp9_lf_thread_free(s);
     free_buffers(s);
     vp9_free_entries(avctx);
     av_freep(&s->td);
@@ -1288,24 +1402,24 @@ static int decode_tiles(AVCodecContext *avctx,
                 data += 4;
                 size -= 4;
             }
-            if (tile_size > size) {
-                ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, INT_MAX, 0);
+            if (tile_size > size)
                 return AVERROR_INVALIDDATA;
-            }
             ret = ff_vp56_init_range_decoder(&td->c_b[tile_col], data, tile_size);
             if (ret < 0)
                 return ret;
-            if (vp56_rac_get_prob_branchy(&td->c_b[tile_col], 128)) { // marker bit
-                ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, INT_MAX, 0);
+            if (vp56_rac_get_prob_branchy(&td->c_b[tile_col], 128)) // marker bit
                 return AVERROR_INVALIDDATA;
-            }
             data += tile_size;
             size -= tile_size;
         }
 
         for (row = tile_row_start; row < tile_row_end;
              row += 8, yoff += ls_y * 64, uvoff += ls_uv * 64 >> s->ss_v) {
-            VP9Filter *lflvl_ptr = s->lflvl;
+            // with frame threading, the loopfilter worker may still be
+            // using the levels and masks of the previous row
+            VP9Filter *lflvl_row = s->lflvl +
+                                   (avctx->active_thread_type ? s->sb_cols * (row >> 3) : 0);
+            VP9Filter *lflvl_ptr = lflvl_row;
             ptrdiff_t yoff2 = yoff, uvoff2 = uvoff;
 
             for (tile_col = 0; tile_col < s->s.h.tiling.tile_cols; tile_col++) {
@@ -1367,11 +1481,18 @@ static int decode_tiles(AVCodecContext *avctx,
                        8 * s->cols * bytesperpixel >> s->ss_h);
             }
 
+#if HAVE_THREADS
+            if (s->lf_thread_init && s->s.h.filter.level) {
+                vp9_lf_post_row(s);
+                continue;
+            }
+#endif
+
             // loopfilter one row
             if (s->s.h.filter.level) {
                 yoff2 = yoff;
                 uvoff2 = uvoff;
-                lflvl_ptr = s->lflvl;
+                lflvl_ptr = lflvl_row;
                 for (col = 0; col < s->cols;
                      col += 8, yoff2 += 64 * bytesperpixel,
                      uvoff2 += 64 * bytesperpixel >> s->ss_h, lflvl_ptr++) {
@@ -1471,29 +1592,13 @@ static av_always_inline
 int loopfilter_proc(AVCodecContext *avctx)
 {
     VP9Context *s = avctx->priv_data;
-    ptrdiff_t uvoff, yoff, ls_y, ls_uv;
-    VP9Filter *lflvl_ptr;
-    int bytesperpixel = s->bytesperpixel, col, i;
-    AVFrame *f;
-
-    f = s->s.frames[CUR_FRAME].tf.f;
-    ls_y = f->linesize[0];
-    ls_uv =f->linesize[1];
+    int i;
 
     for (i = 0; i < s->sb_rows; i++) {
         vp9_await_tile_progress(s, i, s->s.h.tiling.tile_cols);
 
-        if (s->s.h.filter.level) {
-            yoff = (ls_y * 64)*i;
-            uvoff =  (ls_uv * 64 >> s->ss_v)*i;
-            lflvl_ptr = s->lflvl+s->sb_cols*i;
-            for (col = 0; col < s->cols;
-                 col += 8, yoff += 64 * bytesperpixel,
-                 uvoff += 64 * bytesperpixel >> s->ss_h, lflvl_ptr++) {
-                ff_vp9_loopfilter_sb(avctx, lflvl_ptr, i << 3, col,
-                                     yoff, uvoff);
-            }
-        }
+        if (s->s.h.filter.level)
+            loopfilter_sbrow(avctx, s->lflvl + s->sb_cols * i, i);
     }
     return 0;
 }
@@ -1735,6 +1840,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
 #endif
         {
             ret = decode_tiles(avctx, data, size);
+            vp9_lf_wait(s);
             if (ret < 0) {
                 ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, INT_MAX, 0);
                 return ret;
@@ -1824,11 +1930,17 @@ static int init_frames(AVCodecContext *avctx)
 static av_cold int vp9_decode_init(AVCodecContext *avctx)
 {
     VP9Context *s = avctx->priv_data;
+    int ret;
 
     s->last_bpp = 0;
     s->s.h.filter.sharpness = -1;
 
-    return init_frames(avctx);
+    if ((ret = init_frames(avctx)) < 0)
+        return ret;
+    if ((ret = vp9_lf_thread_init(avctx)) < 0)
+        vp9_decode_free(avctx);
+
+    return ret;
 }
 
 #if HAVE_THREADS
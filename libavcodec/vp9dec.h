@@ -105,6 +105,16 @@ typedef struct VP9Context {
     pthread_mutex_t progress_mutex;
     pthread_cond_t progress_cond;
     atomic_int *entries;
+
+    // loopfilter worker, running one sb64 row behind reconstruction when
+    // frame threading is active
+    pthread_t lf_thread;
+    pthread_mutex_t lf_mutex;
+    pthread_cond_t lf_cond;      // signalled when lf_rows_ready grows
+    pthread_cond_t lf_done_cond; // signalled when lf_rows_done grows
+    int lf_thread_init;
+    int lf_rows_ready, lf_rows_done;
+    int lf_exit;
 #endif
 
     uint8_t ss_h, ss_v;
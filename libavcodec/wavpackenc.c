@@ -78,7 +78,7 @@ typedef struct WavPackEncodeContext {
     PutBitContext pb;
     int block_samples;
     int buffer_size;
-    int sample_index;
+    uint32_t sample_index;
     int stereo, stereo_in;
     int ch_offset;
 
@@ -2855,7 +2855,24 @@ static int wavpack_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     int buf_size, ret;
     uint8_t *buf;
 
+    /* From level 3 on each frame may be encoded by whichever frame thread
+     * is free, so the adaptive decorrelation search must not depend on the
+     * blocks this context happened to encode before; start it afresh for
+     * each frame, also without threads, so the output does not depend on
+     * the thread count. */
+    if (avctx->compression_level >= 3) {
+        s->num_terms    = 0;
+        s->shift        = 0;
+        s->false_stereo = 0;
+        s->joint_stereo = 0;
+        s->best_decorr  = s->mask_decorr = 0;
+        s->delta_decay  = 2.0;
+        CLEAR(s->decorr_passes);
+        CLEAR(s->w);
+    }
+
     s->block_samples = frame->nb_samples;
+    s->sample_index  = avctx->frame_number * (uint32_t)avctx->frame_size;
     av_fast_padded_malloc(&s->samples[0], &s->samples_size[0],
                           sizeof(int32_t) * s->block_samples);
     if (!s->samples[0])
@@ -2899,7 +2916,6 @@ static int wavpack_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
         buf      += ret;
         buf_size -= ret;
     }
-    s->sample_index += frame->nb_samples;
 
     avpkt->pts      = frame->pts;
     avpkt->size     = buf - avpkt->data;
@@ -2967,7 +2983,7 @@ AVCodec ff_wavpack_encoder = {
     .init           = wavpack_encode_init,
     .encode2        = wavpack_encode_frame,
     .close          = wavpack_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_FRAME_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_U8P,
                                                      AV_SAMPLE_FMT_S16P,
                                                      AV_SAMPLE_FMT_S32P,
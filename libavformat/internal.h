@@ -76,6 +76,14 @@ struct AVFormatInternal {
     struct PacketList *packet_buffer;
     struct PacketList *packet_buffer_end;
 
+    /**
+     * Unused packet list entries kept for reuse, so that queueing a
+     * packet for interleaving does not allocate.
+     * Muxing only.
+     */
+    struct PacketList *packet_list_pool;
+    int nb_packet_list_pool;
+
     /* av_seek_frame() support */
     int64_t data_offset; /**< offset of the first packet */
 
@@ -399,6 +407,22 @@ char *ff_data_to_hex(char *buf, const uint8_t *src, int size, int lowercase);
  */
 int ff_hex_to_data(uint8_t *data, const char *p);
 
+/**
+ * Get an unused packet list entry from the context's pool, allocating a
+ * new one if the pool is empty. The packet of the entry holds stale
+ * fields and must be overwritten, e.g. with av_packet_move_ref().
+ *
+ * @return the entry or NULL on allocation failure
+ */
+struct PacketList *ff_packet_list_entry_get(AVFormatContext *s);
+
+/**
+ * Return a packet list entry to the context's pool and set *pktl to NULL.
+ * The entry is freed instead if the pool is full.
+ * The packet of the entry must not hold any reference anymore.
+ */
+void ff_packet_list_entry_release(AVFormatContext *s, struct PacketList **pktl);
+
 /**
  * Add packet to an AVFormatContext's packet_buffer list, determining its
  * interleaved position using compare() function argument.
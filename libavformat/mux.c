@@ -827,6 +827,35 @@ static int prepare_input_packet(AVFormatContext *s, AVStream *st, AVPacket *pkt)
 
 #define CHUNK_START 0x1000
 
+/* Entries kept for reuse at most, so that a burst of interleaving does not
+ * keep its peak memory for the rest of the muxing. */
+#define MAX_PACKET_LIST_POOL 256
+
+PacketList *ff_packet_list_entry_get(AVFormatContext *s)
+{
+    PacketList *pktl = s->internal->packet_list_pool;
+
+    if (pktl) {
+        s->internal->packet_list_pool = pktl->next;
+        s->internal->nb_packet_list_pool--;
+        pktl->next = NULL;
+        return pktl;
+    }
+    return av_mallocz(sizeof(PacketList));
+}
+
+void ff_packet_list_entry_release(AVFormatContext *s, PacketList **pktl)
+{
+    if (s->internal->nb_packet_list_pool >= MAX_PACKET_LIST_POOL) {
+        av_freep(pktl);
+        return;
+    }
+    (*pktl)->next = s->internal->packet_list_pool;
+    s->internal->packet_list_pool = *pktl;
+    s->internal->nb_packet_list_pool++;
+    *pktl = NULL;
+}
+
 int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
                              int (*compare)(AVFormatContext *, const AVPacket *, const AVPacket *))
 {
@@ -835,13 +864,13 @@ int ff_interleave_add_packet(AVFormatContext *s, AVPacket *pkt,
     AVStream *st = s->streams[pkt->stream_index];
     int chunked  = s->max_chunk_size || s->max_chunk_duration;
 
-    this_pktl    = av_malloc(sizeof(PacketList));
+    this_pktl    = ff_packet_list_entry_get(s);
     if (!this_pktl) {
         av_packet_unref(pkt);
         return AVERROR(ENOMEM);
     }
     if ((ret = av_packet_make_refcounted(pkt)) < 0) {
-        av_free(this_pktl);
+        ff_packet_list_entry_release(s, &this_pktl);
         av_packet_unref(pkt);
         return ret;
     }
@@ -1022,7 +1051,7 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
                 st->internal->last_in_packet_buffer = NULL;
 
             av_packet_unref(&pktl->pkt);
-            av_freep(&pktl);
+            ff_packet_list_entry_release(s, &pktl);
             flush = 0;
         }
     }
@@ -1039,7 +1068,7 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *out,
 
         if (st->internal->last_in_packet_buffer == pktl)
             st->internal->last_in_packet_buffer = NULL;
-        av_freep(&pktl);
+        ff_packet_list_entry_release(s, &pktl);
 
         return 1;
     } else {
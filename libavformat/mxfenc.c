@@ -3123,7 +3123,7 @@ static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket
             while (pktl) {
                 PacketList *next = pktl->next;
                 av_packet_unref(&pktl->pkt);
-                av_freep(&pktl);
+                ff_packet_list_entry_release(s, &pktl);
                 pktl = next;
             }
             if (last)
@@ -3143,7 +3143,7 @@ static int mxf_interleave_get_packet(AVFormatContext *s, AVPacket *out, AVPacket
             s->streams[pktl->pkt.stream_index]->internal->last_in_packet_buffer= NULL;
         if(!s->internal->packet_buffer)
             s->internal->packet_buffer_end= NULL;
-        av_freep(&pktl);
+        ff_packet_list_entry_release(s, &pktl);
         return 1;
     } else {
     out:
@@ -4454,6 +4454,11 @@ void avformat_free_context(AVFormatContext *s)
     av_packet_free(&s->internal->parse_pkt);
     av_freep(&s->streams);
     flush_packet_queue(s);
+    while (s->internal->packet_list_pool) {
+        PacketList *pktl = s->internal->packet_list_pool;
+        s->internal->packet_list_pool = pktl->next;
+        av_free(pktl);
+    }
     av_freep(&s->internal);
     av_freep(&s->url);
     av_free(s);
@@ -0,0 +1,271 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Two-pass rate control statistics test.
+ * Encodes generated video in two passes, once with the text stats_out /
+ * stats_in statistics and once with the binary AV_PKT_DATA_RC_STATS side
+ * data, and checks that both second passes produce the same output. Then
+ * runs the first pass at a quarter of the area and checks that the second
+ * pass still lands close to the target bitrate.
+ */
+
+#include <string.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+
+#define WIDTH           352
+#define HEIGHT          288
+#define NUMBER_OF_FRAMES 60
+#define FRAME_RATE      25
+#define BIT_RATE        2000000
+
+typedef struct Stats {
+    uint8_t *text;
+    size_t   text_size;
+    uint8_t *bin;
+    size_t   bin_size;
+} Stats;
+
+typedef struct Output {
+    uint8_t *data;
+    size_t   size;
+} Output;
+
+static int append(uint8_t **buf, size_t *size, const void *data, size_t len,
+                  int terminate)
+{
+    uint8_t *tmp = av_realloc(*buf, *size + len + terminate);
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    memcpy(tmp + *size, data, len);
+    *size += len;
+    if (terminate)
+        tmp[*size] = 0;
+    *buf = tmp;
+    return 0;
+}
+
+/* generate the n-th picture, the content is scaled to the picture size so
+ * that a smaller first pass sees the same scene */
+static void generate_frame(AVFrame *frame, int n)
+{
+    int x, y, p;
+
+    for (y = 0; y < frame->height; y++) {
+        for (x = 0; x < frame->width; x++) {
+            int X = x * WIDTH  / frame->width;
+            int Y = y * HEIGHT / frame->height;
+            frame->data[0][y * frame->linesize[0] + x] =
+                ((X + n * 3) ^ (Y - n * 2)) + ((X * Y / (n % 17 + 3)) & 31) +
+                (n > 20 && n < 30 ? 100 : 0);
+        }
+    }
+    for (p = 1; p < 3; p++)
+        for (y = 0; y < frame->height / 2; y++)
+            for (x = 0; x < frame->width / 2; x++)
+                frame->data[p][y * frame->linesize[p] + x] =
+                    128 + ((x * 2 * WIDTH / frame->width + y + n * p) & 15);
+}
+
+static int collect_stats(AVCodecContext *ctx, const AVPacket *pkt,
+                         Stats *stats)
+{
+    int ret, size;
+    uint8_t *sd;
+
+    if (ctx->stats_out && *ctx->stats_out) {
+        ret = append(&stats->text, &stats->text_size,
+                     ctx->stats_out, strlen(ctx->stats_out), 1);
+        if (ret < 0)
+            return ret;
+        ctx->stats_out[0] = 0;
+    }
+
+    sd = av_packet_get_side_data(pkt, AV_PKT_DATA_RC_STATS, &size);
+    if (sd)
+        return append(&stats->bin, &stats->bin_size, sd, size, 0);
+    return 0;
+}
+
+/*
+ * pass 1 writes the statistics to stats, in binary form if binary is set,
+ * pass 2 reads them from there.
+ */
+static int encode(const AVCodec *enc, int width, int height, int pass,
+                  int binary, Stats *stats, Output *out)
+{
+    AVCodecContext *ctx;
+    AVPacket *pkt;
+    AVFrame *frame;
+    int i = 0, ret;
+
+    ctx   = avcodec_alloc_context3(enc);
+    pkt   = av_packet_alloc();
+    frame = av_frame_alloc();
+    if (!ctx || !pkt || !frame) {
+        av_log(NULL, AV_LOG_ERROR, "Can't allocate encoder\n");
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ctx->width        = width;
+    ctx->height       = height;
+    ctx->pix_fmt      = AV_PIX_FMT_YUV420P;
+    ctx->time_base    = (AVRational){ 1, FRAME_RATE };
+    ctx->bit_rate     = BIT_RATE;
+    ctx->gop_size     = 12;
+    ctx->max_b_frames = 2;
+    ctx->flags       |= AV_CODEC_FLAG_BITEXACT;
+
+    if (pass == 1) {
+        ctx->flags |= AV_CODEC_FLAG_PASS1;
+        if (binary)
+            ctx->export_side_data |= AV_CODEC_EXPORT_DATA_RC_STATS;
+    } else {
+        ctx->flags |= AV_CODEC_FLAG_PASS2;
+        if (binary) {
+            ret = av_opt_set_bin(ctx->priv_data, "rc_stats",
+                                 stats->bin, stats->bin_size, 0);
+        } else {
+            ctx->stats_in = av_strdup((char *)stats->text);
+            ret = ctx->stats_in ? 0 : AVERROR(ENOMEM);
+        }
+        if (ret < 0)
+            goto end;
+    }
+
+    ret = avcodec_open2(ctx, enc, NULL);
+    if (ret < 0) {
+        av_log(ctx, AV_LOG_ERROR, "Can't open encoder\n");
+        goto end;
+    }
+
+    frame->width  = width;
+    frame->height = height;
+    frame->format = ctx->pix_fmt;
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto end;
+
+    do {
+        if (i < NUMBER_OF_FRAMES) {
+            ret = av_frame_make_writable(frame);
+            if (ret < 0)
+                goto end;
+            generate_frame(frame, i);
+            frame->pts = i++;
+            ret = avcodec_send_frame(ctx, frame);
+        } else {
+            ret = avcodec_send_frame(ctx, NULL);
+        }
+        if (ret < 0)
+            goto end;
+
+        while ((ret = avcodec_receive_packet(ctx, pkt)) >= 0) {
+            if (pass == 1)
+                ret = collect_stats(ctx, pkt, stats);
+            if (ret >= 0)
+                ret = append(&out->data, &out->size, pkt->data, pkt->size, 0);
+            av_packet_unref(pkt);
+            if (ret < 0)
+                goto end;
+        }
+    } while (ret == AVERROR(EAGAIN));
+
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+end:
+    avcodec_free_context(&ctx);
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    return ret;
+}
+
+static void free_stats(Stats *stats)
+{
+    av_freep(&stats->text);
+    av_freep(&stats->bin);
+    stats->text_size = stats->bin_size = 0;
+}
+
+static void free_output(Output *out)
+{
+    av_freep(&out->data);
+    out->size = 0;
+}
+
+int main(void)
+{
+    const AVCodec *enc;
+    Stats text = { 0 }, bin = { 0 }, small = { 0 };
+    Output out[6] = { { 0 } };
+    int64_t target = (int64_t)BIT_RATE * NUMBER_OF_FRAMES / FRAME_RATE / 8;
+    int i, ret = 1;
+
+    enc = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    if (!enc) {
+        av_log(NULL, AV_LOG_ERROR, "Can't find MPEG-4 encoder\n");
+        return 1;
+    }
+
+    if (encode(enc, WIDTH, HEIGHT, 1, 0, &text, &out[0]) < 0 ||
+        encode(enc, WIDTH, HEIGHT, 2, 0, &text, &out[1]) < 0 ||
+        encode(enc, WIDTH, HEIGHT, 1, 1, &bin,  &out[2]) < 0 ||
+        encode(enc, WIDTH, HEIGHT, 2, 1, &bin,  &out[3]) < 0 ||
+        encode(enc, WIDTH / 2, HEIGHT / 2, 1, 1, &small, &out[4]) < 0 ||
+        encode(enc, WIDTH, HEIGHT, 2, 1, &small, &out[5]) < 0)
+        goto end;
+
+    if (!text.text_size || text.bin_size) {
+        av_log(NULL, AV_LOG_ERROR, "Text first pass wrote no text statistics\n");
+        goto end;
+    }
+    if (!bin.bin_size || bin.text_size) {
+        av_log(NULL, AV_LOG_ERROR, "Binary first pass wrote no binary statistics\n");
+        goto end;
+    }
+    if (out[0].size != out[2].size || memcmp(out[0].data, out[2].data, out[0].size)) {
+        av_log(NULL, AV_LOG_ERROR, "First pass output depends on the statistics format\n");
+        goto end;
+    }
+    if (out[1].size != out[3].size || memcmp(out[1].data, out[3].data, out[1].size)) {
+        av_log(NULL, AV_LOG_ERROR, "Second pass output differs: %d bytes from text "
+               "statistics, %d from binary\n", (int)out[1].size, (int)out[3].size);
+        goto end;
+    }
+    if (FFABS((int64_t)out[5].size - target) > target / 5) {
+        av_log(NULL, AV_LOG_ERROR, "Second pass from a %dx%d first pass: "
+               "%d bytes, target %"PRId64"\n",
+               WIDTH / 2, HEIGHT / 2, (int)out[5].size, target);
+        goto end;
+    }
+    ret = 0;
+
+end:
+    free_stats(&text);
+    free_stats(&bin);
+    free_stats(&small);
+    for (i = 0; i < FF_ARRAY_ELEMS(out); i++)
+        free_output(&out[i]);
+    return ret;
+}
@@ -439,6 +439,40 @@ static void check_loop_filter_intra(void)
     }
 }
 
+static void check_startcode(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf, [4096 + AV_INPUT_BUFFER_PADDING_SIZE]);
+    H264DSPContext h;
+    int i, j;
+
+    declare_func(int, const uint8_t *buf, int size);
+
+    ff_h264dsp_init(&h, 8, 1);
+
+    if (check_func(h.startcode_find_candidate, "startcode_find_candidate")) {
+        for (j = 0; j < 64; j++) {
+            int size = j ? rnd() % 4096 + 1 : 4096;
+            int res0, res1;
+
+            for (i = 0; i < 4096 + AV_INPUT_BUFFER_PADDING_SIZE; i++)
+                buf[i] = rnd() | 1;
+            /* place a few zero bytes, sometimes none, sometimes past size */
+            for (i = rnd() % 4; i > 0; i--)
+                buf[rnd() % 4096] = 0;
+
+            res0 = call_ref(buf, size);
+            res1 = call_new(buf, size);
+            if (res0 != res1) {
+                fprintf(stderr, "startcode_find_candidate: size:%d %d != %d\n",
+                        size, res0, res1);
+                fail();
+            }
+        }
+        memset(buf, 0xff, 4096);
+        bench_new(buf, 4096);
+    }
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
@@ -450,4 +484,7 @@ void checkasm_check_h264dsp(void)
 
     check_loop_filter_intra();
     report("loop_filter_intra");
+
+    check_startcode();
+    report("startcode");
 }
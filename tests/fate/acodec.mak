@@ -168,6 +168,19 @@ FATE_ACODEC-$(call ENCDEC, WAVPACK, WV) += fate-acodec-wavpack
 fate-acodec-wavpack: FMT = wv
 fate-acodec-wavpack: CODEC = wavpack -compression_level 1
 
+# frame threads are not used below level 3, the output must match the above
+FATE_ACODEC-$(call ENCDEC, WAVPACK, WV) += fate-acodec-wavpack-threads
+fate-acodec-wavpack-threads: FMT = wv
+fate-acodec-wavpack-threads: CODEC = wavpack -compression_level 1 -threads 4
+
+FATE_ACODEC-$(call ENCDEC, WAVPACK, WV) += fate-acodec-wavpack-level3
+fate-acodec-wavpack-level3: FMT = wv
+fate-acodec-wavpack-level3: CODEC = wavpack -compression_level 3
+
+FATE_ACODEC-$(call ENCDEC, WAVPACK, WV) += fate-acodec-wavpack-level3-threads
+fate-acodec-wavpack-level3-threads: FMT = wv
+fate-acodec-wavpack-level3-threads: CODEC = wavpack -compression_level 3 -threads 4
+
 FATE_ACODEC-$(call ENCDEC, TTA, TTA) += fate-acodec-tta
 fate-acodec-tta: FMT = tta
 
@@ -3,6 +3,11 @@ fate-api-flac: $(APITESTSDIR)/api-flac-test$(EXESUF)
 fate-api-flac: CMD = run $(APITESTSDIR)/api-flac-test$(EXESUF)
 fate-api-flac: CMP = null
 
+FATE_API_LIBAVCODEC-$(CONFIG_MPEG4_ENCODER) += fate-api-rcstats
+fate-api-rcstats: $(APITESTSDIR)/api-rcstats-test$(EXESUF)
+fate-api-rcstats: CMD = run $(APITESTSDIR)/api-rcstats-test$(EXESUF)
+fate-api-rcstats: CMP = null
+
 FATE_API_SAMPLES_LIBAVFORMAT-$(call DEMDEC, FLV, FLV) += fate-api-band
 fate-api-band: $(APITESTSDIR)/api-band-test$(EXESUF)
 fate-api-band: CMD = run $(APITESTSDIR)/api-band-test$(EXESUF) $(TARGET_SAMPLES)/mpeg4/resize_down-up.h263
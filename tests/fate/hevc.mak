@@ -239,6 +239,23 @@ $(foreach N,$(HEVC_SAMPLES_444_8BIT),$(eval $(call FATE_HEVC_TEST_444_8BIT,$(N))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT),$(eval $(call FATE_HEVC_TEST_444_12BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT_LARGE),$(eval $(call FATE_HEVC_TEST_444_12BIT_LARGE,$(N))))
 
+# tiles decoded in parallel on slice threads must match the serial output,
+# including slices that disable deblocking
+HEVC_SAMPLES_SLICE_THREADS =    \
+    DBLK_A_SONY_3               \
+    DBLK_B_SONY_3               \
+    DBLK_C_SONY_3               \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+
+define FATE_HEVC_TEST_SLICE_THREADS
+FATE_HEVC += fate-hevc-conformance-$(1)-slice-threads
+fate-hevc-conformance-$(1)-slice-threads: CMD = threads=4 thread_type=slice framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-conformance-$(1)-slice-threads: REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+endef
+
+$(foreach N,$(HEVC_SAMPLES_SLICE_THREADS),$(eval $(call FATE_HEVC_TEST_SLICE_THREADS,$(N))))
+
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC_LARGE += fate-hevc-paramchange-yuv420p-yuv420p10
 
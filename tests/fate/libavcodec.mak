@@ -46,6 +46,11 @@ fate-dct8x8: libavcodec/tests/dct$(EXESUF)
 fate-dct8x8: CMD = run libavcodec/tests/dct$(EXESUF)
 fate-dct8x8: CMP = null
 
+FATE_LIBAVCODEC-$(CONFIG_H264PARSE) += fate-h2645-parse
+fate-h2645-parse: libavcodec/tests/h2645_parse$(EXESUF)
+fate-h2645-parse: CMD = run libavcodec/tests/h2645_parse$(EXESUF)
+fate-h2645-parse: CMP = null
+
 FATE_LIBAVCODEC-$(CONFIG_H264_METADATA_BSF) += fate-h264-levels
 fate-h264-levels: libavcodec/tests/h264_levels$(EXESUF)
 fate-h264-levels: CMD = run libavcodec/tests/h264_levels$(EXESUF)
@@ -56,6 +61,14 @@ fate-h265-levels: libavcodec/tests/h265_levels$(EXESUF)
 fate-h265-levels: CMD = run libavcodec/tests/h265_levels$(EXESUF)
 fate-h265-levels: REF = /dev/null
 
+FATE_LIBAVCODEC-$(call ALLYES, H264_DECODER H264_PARSER) += fate-h264-lowres
+fate-h264-lowres: libavcodec/tests/lowres$(EXESUF)
+fate-h264-lowres: CMD = run libavcodec/tests/lowres$(EXESUF) h264
+
+FATE_LIBAVCODEC-$(call ALLYES, HEVC_DECODER HEVC_PARSER) += fate-hevc-lowres
+fate-hevc-lowres: libavcodec/tests/lowres$(EXESUF)
+fate-hevc-lowres: CMD = run libavcodec/tests/lowres$(EXESUF) hevc
+
 FATE_LIBAVCODEC-$(CONFIG_IIRFILTER) += fate-iirfilter
 fate-iirfilter: libavcodec/tests/iirfilter$(EXESUF)
 fate-iirfilter: CMD = run libavcodec/tests/iirfilter$(EXESUF)
@@ -75,6 +88,11 @@ fate-mathops: libavcodec/tests/mathops$(EXESUF)
 fate-mathops: CMD = run libavcodec/tests/mathops$(EXESUF)
 fate-mathops: CMP = null
 
+FATE_LIBAVCODEC-$(CONFIG_STARTCODE) += fate-startcode
+fate-startcode: libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMD = run libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMP = null
+
 FATE_LIBAVCODEC-$(CONFIG_JPEG2000_ENCODER) += fate-j2k-dwt
 fate-j2k-dwt: libavcodec/tests/jpeg2000dwt$(EXESUF)
 fate-j2k-dwt: CMD = run libavcodec/tests/jpeg2000dwt$(EXESUF)
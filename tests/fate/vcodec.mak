@@ -348,6 +348,20 @@ fate-vsynth%-msmpeg4v2:          ENCOPTS = -qscale 10
 FATE_VCODEC-$(call ENCDEC, PNG, AVI)    += mpng
 fate-vsynth%-mpng:               CODEC   = png
 
+# deflate blocks on slice threads must decode to the same frames as mpng
+FATE_PNG_DBLOCK-$(call ENCDEC, PNG, AVI) += fate-png-dblock
+fate-png-dblock: tests/data/vsynth1.yuv
+fate-png-dblock: CMD = enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv avi "-c png -dblock_size 8192 -threads 4 -thread_type slice" rawvideo "-s 352x288 -pix_fmt yuv420p -vsync 0"
+fate-png-dblock: CMP_UNIT = 1
+FATE_AVCONV += $(FATE_PNG_DBLOCK-yes)
+
+# PIZ round trip, must decode to the same frames as uncompressed EXR
+FATE_EXR_PIZ-$(call ENCDEC, EXR, MOV) += fate-exr-piz-half fate-exr-piz-float
+fate-exr-piz-%: tests/data/vsynth1.yuv
+fate-exr-piz-%: CMD = enc_dec "rawvideo -s 352x288 -pix_fmt yuv420p" tests/data/vsynth1.yuv mov "-c exr -compression piz -format $(@:fate-exr-piz-%=%) -pix_fmt gbrpf32le" rawvideo "-s 352x288 -pix_fmt yuv420p -vsync 0"
+fate-exr-piz-%: CMP_UNIT = 1
+FATE_AVCONV += $(FATE_EXR_PIZ-yes)
+
 FATE_VCODEC-$(call ENCDEC, MSVIDEO1, AVI) += msvideo1
 
 FATE_VCODEC-$(call ENCDEC, PRORES, MOV) += prores prores_int prores_444 prores_444_int prores_ks
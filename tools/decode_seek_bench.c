@@ -0,0 +1,265 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the latency from a seek (avcodec_flush_buffers() followed by
+ * decoding from a keyframe) to the first decoded frame.
+ * The packets of the first video stream are read into memory beforehand,
+ * so that only decoder time is measured.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+
+#include "libavutil/adler32.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+#include "libavcodec/avcodec.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static void usage(int ret)
+{
+    fprintf(ret ? stderr : stdout,
+            "Usage: decode_seek_bench [options] file\n"
+            "Options:\n"
+            "    -t threads   number of decoding threads (default 1)\n"
+            "    -T type      threading type: frame, slice or both (default frame)\n"
+            "    -n seeks     number of seeks to perform (default 100)\n"
+            "    -p packets   packets decoded between seeks (default 8)\n"
+            "    -s seed      seed for choosing the seek targets (default 1)\n"
+            "    -v           print the target and a checksum of the first frame of each seek\n"
+            );
+    exit(ret);
+}
+
+static uint32_t frame_checksum(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    uint32_t crc = 1;
+    int plane, y;
+
+    for (plane = 0; plane < 4 && frame->data[plane]; plane++) {
+        int linesize = av_image_get_linesize(frame->format, frame->width, plane);
+        int h        = frame->height;
+
+        if (plane == 1 || plane == 2)
+            h = AV_CEIL_RSHIFT(h, desc->log2_chroma_h);
+        for (y = 0; y < h; y++)
+            crc = av_adler32_update(crc, frame->data[plane] + y * frame->linesize[plane],
+                                    linesize);
+    }
+    return crc;
+}
+
+/**
+ * Feed packets starting at *pos to the decoder until a frame comes out.
+ * @return 0 on success, AVERROR_EOF if the packets ran out, or another
+ *         negative error code
+ */
+static int decode_one(AVCodecContext *dec, AVPacket **pkts, int nb_pkts,
+                      int *pos, AVFrame *frame)
+{
+    int ret;
+
+    while (1) {
+        ret = avcodec_receive_frame(dec, frame);
+        if (ret != AVERROR(EAGAIN))
+            return ret;
+
+        ret = avcodec_send_packet(dec, *pos < nb_pkts ? pkts[*pos] : NULL);
+        if (ret < 0 && ret != AVERROR_EOF)
+            return ret;
+        if (*pos < nb_pkts)
+            (*pos)++;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename;
+    AVFormatContext *fmt = NULL;
+    AVCodecContext *dec = NULL;
+    AVCodec *codec;
+    AVPacket **pkts = NULL, *pkt = NULL;
+    AVFrame *frame = NULL;
+    int *keyframes = NULL;
+    int nb_pkts = 0, nb_keyframes = 0;
+    int threads = 1, thread_type = FF_THREAD_FRAME, nb_seeks = 100, nb_play = 8;
+    int verbose = 0, stream, opt, i, ret;
+    unsigned seed = 1;
+    int64_t total = 0, best = INT64_MAX, worst = 0, total_flush = 0;
+    AVLFG lfg;
+
+    while ((opt = getopt(argc, argv, "ht:T:n:p:s:v")) != -1) {
+        switch (opt) {
+        case 't':
+            threads = atoi(optarg);
+            break;
+        case 'T':
+            if (!strcmp(optarg, "frame"))
+                thread_type = FF_THREAD_FRAME;
+            else if (!strcmp(optarg, "slice"))
+                thread_type = FF_THREAD_SLICE;
+            else if (!strcmp(optarg, "both"))
+                thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+            else
+                usage(1);
+            break;
+        case 'n':
+            nb_seeks = atoi(optarg);
+            break;
+        case 'p':
+            nb_play = atoi(optarg);
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'v':
+            verbose = 1;
+            break;
+        case 'h':
+            usage(0);
+        default:
+            usage(1);
+        }
+    }
+    if (optind + 1 != argc || threads < 0 || nb_seeks < 1 || nb_play < 0)
+        usage(1);
+    filename = argv[optind];
+
+    if ((ret = avformat_open_input(&fmt, filename, NULL, NULL)) < 0) {
+        fprintf(stderr, "%s: %s\n", filename, av_err2str(ret));
+        return 1;
+    }
+    if ((ret = avformat_find_stream_info(fmt, NULL)) < 0) {
+        fprintf(stderr, "%s: could not find codec parameters: %s\n", filename,
+                av_err2str(ret));
+        goto end;
+    }
+    ret = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (ret < 0) {
+        fprintf(stderr, "%s: no decodable video stream: %s\n", filename,
+                av_err2str(ret));
+        goto end;
+    }
+    stream = ret;
+
+    dec   = avcodec_alloc_context3(codec);
+    pkt   = av_packet_alloc();
+    frame = av_frame_alloc();
+    if (!dec || !pkt || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if ((ret = avcodec_parameters_to_context(dec, fmt->streams[stream]->codecpar)) < 0)
+        goto end;
+    dec->thread_count = threads;
+    dec->thread_type  = thread_type;
+    if ((ret = avcodec_open2(dec, codec, NULL)) < 0) {
+        fprintf(stderr, "Could not open the %s decoder: %s\n", codec->name,
+                av_err2str(ret));
+        goto end;
+    }
+
+    while ((ret = av_read_frame(fmt, pkt)) >= 0) {
+        if (pkt->stream_index != stream) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        if ((ret = av_reallocp_array(&pkts, nb_pkts + 1, sizeof(*pkts))) < 0 ||
+            (ret = av_reallocp_array(&keyframes, nb_keyframes + 1, sizeof(*keyframes))) < 0)
+            goto end;
+        if (pkt->flags & AV_PKT_FLAG_KEY)
+            keyframes[nb_keyframes++] = nb_pkts;
+        pkts[nb_pkts++] = pkt;
+        if (!(pkt = av_packet_alloc())) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+    if (ret != AVERROR_EOF)
+        goto end;
+    if (!nb_keyframes) {
+        fprintf(stderr, "%s: no keyframes\n", filename);
+        ret = AVERROR_INVALIDDATA;
+        goto end;
+    }
+
+    av_lfg_init(&lfg, seed);
+    for (i = 0; i < nb_seeks; i++) {
+        int target = keyframes[av_lfg_get(&lfg) % nb_keyframes];
+        int pos = target, j;
+        int64_t t, t_flush;
+
+        t = av_gettime_relative();
+        avcodec_flush_buffers(dec);
+        t_flush = av_gettime_relative() - t;
+        ret = decode_one(dec, pkts, nb_pkts, &pos, frame);
+        t = av_gettime_relative() - t;
+        if (ret < 0) {
+            fprintf(stderr, "seek %d to packet %d: %s\n", i, target, av_err2str(ret));
+            goto end;
+        }
+
+        total       += t;
+        total_flush += t_flush;
+        best   = FFMIN(best, t);
+        worst  = FFMAX(worst, t);
+        if (verbose)
+            printf("seek %d: packet %d pts %"PRId64" checksum 0x%08"PRIx32" %"PRId64" us\n",
+                   i, target, frame->pts, frame_checksum(frame), t);
+        av_frame_unref(frame);
+
+        /* Keep decoding for a while, so that the next flush finds frames in
+         * flight as it would during playback. */
+        for (j = 0; j < nb_play; j++) {
+            ret = decode_one(dec, pkts, nb_pkts, &pos, frame);
+            if (ret == AVERROR_EOF)
+                break;
+            if (ret < 0)
+                goto end;
+            av_frame_unref(frame);
+        }
+    }
+
+    printf("%s: %s, %d threads, %d seeks over %d keyframes: "
+           "avg %"PRId64" us (flush %"PRId64" us), min %"PRId64" us, max %"PRId64" us\n",
+           filename, codec->name, dec->thread_count, nb_seeks, nb_keyframes,
+           total / nb_seeks, total_flush / nb_seeks, best, worst);
+    ret = 0;
+
+end:
+    for (i = 0; i < nb_pkts; i++)
+        av_packet_free(&pkts[i]);
+    av_freep(&pkts);
+    av_freep(&keyframes);
+    av_packet_free(&pkt);
+    av_frame_free(&frame);
+    avcodec_free_context(&dec);
+    avformat_close_input(&fmt);
+
+    return ret < 0;
+}